@@ -0,0 +1,212 @@
+/* File: batch.c
+   Date: Oct. 16, 2026
+   Language: C (UNIX)
+   Purpose: Hawk Emulator, batch mode console;
+		runs the program without the curses front panel, then
+		reports the display and the final machine state on stdout.
+*/
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "bus.h"
+#include "decode.h"
+#include "block.h"
+#include "mmu.h"
+#include "machine.h"
+#include "batch.h"
+#include "snapshot.h"
+#include "forkserver.h"
+
+/*****************************
+ * memory mapped I/O devices *
+ *****************************/
+
+/* the display has a fixed size; addresses relative to DISPBASE and
+   KBDBASE are as in console.c */
+#define BATCHLINES 24
+#define BATCHCOLS  80
+#define DISPLINES  0
+#define DISPCOLS   4
+#define DISPSTART  0x100
+#define DISPSIZE   (BATCHLINES * BATCHCOLS)
+#define KBDDATA    0
+#define KBDSTAT    4
+
+static BYTE screen[ DISPSIZE ]; /* the display, one byte per character */
+
+void batch_dispwrite( struct hawk_machine * hm, WORD addr, WORD val ) {
+	/* store the 4 characters of val in the display at addr */
+	WORD relad = addr - (DISPBASE + DISPSTART);
+	int i;
+	if (addr < (DISPBASE + DISPSTART)) return;
+	for (i = 0; i < 4; i++) {
+		if ((relad + i) < DISPSIZE) screen[relad + i] = val & 0x7F;
+		val >>= 8;
+	}
+}
+
+WORD batch_dispread( struct hawk_machine * hm, WORD addr ) {
+	/* get the 4 characters from the display at addr */
+	if (addr >= (DISPBASE + DISPSTART)) {
+		WORD relad = addr - (DISPBASE + DISPSTART);
+		if ((relad + 3) >= DISPSIZE) return 0xFFFFFFFF;
+		return ((WORD)screen[relad + 3] << 24)
+		     | ((WORD)screen[relad + 2] << 16)
+		     | ((WORD)screen[relad + 1] << 8)
+		     |  (WORD)screen[relad];
+	} else if (addr == (DISPBASE + DISPLINES)) {
+		return BATCHLINES;
+	} else if (addr == (DISPBASE + DISPCOLS)) {
+		return BATCHCOLS;
+	}
+	return 0xFFFFFFFF;
+}
+
+void batch_kbdwrite( struct hawk_machine * hm, WORD addr, WORD val ) {
+	/* the keyboard never interrupts, so there is nothing to enable */
+}
+
+WORD batch_kbdread( struct hawk_machine * hm, WORD addr ) {
+	/* the keyboard is never ready */
+	if (addr == (KBDBASE + KBDSTAT)) {
+		hm->morecycles += hm->cycles; /* as with the console, give */
+		hm->cycles = 0;               /* batch_console a look */
+	}
+	return 0;
+}
+
+/*****************
+ * batch control *
+ *****************/
+
+/* most cycles run between checks of the limits */
+#define SLICE 0x100000
+
+static int running = 0;
+static int forked = 0;        /* nonzero in a job of the fork server */
+static struct timespec start; /* when the program began to run */
+static WORD startcycles;      /* the counts then, nonzero if the */
+static uint64_t startinstr;   /* machine was restored from a snapshot,
+				 or for a job, at the breakpoint */
+
+static void begin( struct hawk_machine * hm ) {
+	/* the program begins to run, or a job of the fork server does */
+	clock_gettime( CLOCK_MONOTONIC, &start );
+	startcycles = hm->cycles + hm->morecycles;
+	startinstr = hm->instructions;
+}
+
+static void report( struct hawk_machine * hm, const char * why,
+		    int status ) {
+	/* put the display and the final state to stdout and exit */
+	struct timespec now;
+	double secs;
+	int line, col, i;
+
+	forkserver_report( hm, why, status,
+			   hm->cycles + hm->morecycles - startcycles,
+			   hm->instructions - startinstr );
+	clock_gettime( CLOCK_MONOTONIC, &now );
+	secs = (double)(now.tv_sec - start.tv_sec)
+	     + (double)(now.tv_nsec - start.tv_nsec) / 1e9;
+
+	for (line = BATCHLINES; line > 0; line--) { /* drop blank lines */
+		for (col = 0; col < BATCHCOLS; col++) {
+			if (screen[(line - 1) * BATCHCOLS + col] > ' ') break;
+		}
+		if (col < BATCHCOLS) break;
+	}
+	for (i = 0; i < line; i++) {
+		BYTE * p = &screen[i * BATCHCOLS];
+		int end = BATCHCOLS;
+		while ((end > 0) && ((p[end - 1] == ' ') || (p[end - 1] == 0))) {
+			end--;
+		}
+		for (col = 0; col < end; col++) {
+			if (p[col] >= ' ') {
+				putchar( p[col] );
+			} else {
+				putchar( p[col] | '@' );
+			}
+		}
+		putchar( '\n' );
+	}
+	if (line > 0) putchar( '\n' );
+
+	printf( "stop:         %s\n", why );
+	printf( "PC:  %08"PRIX32"  PSW: %08"PRIX32"\n", hm->pc, hm->psw );
+	for (i = 1; i < 16; i++) {
+		printf( "R%X:  %08"PRIX32"%s", i, hm->r[i],
+			((i % 5) == 0) ? "\n" : "  " );
+	}
+	printf( "cycles:       %"PRIu32"\n",
+		(WORD)(hm->cycles + hm->morecycles) );
+	printf( "instructions: %"PRIu64"\n", hm->instructions );
+	printf( "seconds:      %.3f\n", secs );
+	if (secs > 0.0) {
+		printf( "MIPS:         %.2f\n",
+			(double)(hm->instructions - startinstr) / secs / 1e6 );
+	}
+	exit( status );
+}
+
+void batch_startup() {
+	/* startup, called from console_startup */
+	int i;
+	for (i = 0; i < DISPSIZE; i++) screen[i] = ' ';
+}
+
+void batch_console( struct hawk_machine * hm ) {
+	/* called whenever the console would have been; the first call
+	   starts the program as the r command does, later calls stop it
+	   or allow another slice of cycles */
+	WORD used = hm->cycles + hm->morecycles - startcycles;
+	WORD slice = SLICE;
+	int limited = (forkname == NULL) || forked; /* the limits of the
+						       fork server are for
+						       its jobs */
+
+	if (!running) {
+		running = 1;
+		begin( hm );
+		used = 0;
+	} else if (hm->pc == 0) {
+		report( hm, "pc = 0", EXIT_SUCCESS );
+	} else if (hm->pc == hm->breakpoint) {
+		if ((snapname != NULL) && !forked
+		&&  !snapshot_save( hm, snapname )) {
+			fputs( progname, stderr );
+			fputs( " -S ", stderr );
+			fputs( snapname, stderr );
+			fputs( ": cannot save snapshot\n", stderr );
+		}
+		if (limited) report( hm, "pc = breakpoint", EXIT_SUCCESS );
+		forkserver_run( hm, forkname ); /* returns only in a job */
+		forked = 1;
+		limited = 1;
+		begin( hm );
+		used = 0;
+	} else if (!limited) {
+		/* run on to the breakpoint */
+	} else if ((cyclelimit != 0) && (used >= cyclelimit)) {
+		report( hm, "cycle limit", EXIT_FAILURE );
+	} else if ((instrlimit != 0)
+	       &&  ((hm->instructions - startinstr) >= instrlimit)) {
+		report( hm, "instruction limit", EXIT_FAILURE );
+	}
+
+	if (limited && (cyclelimit != 0) && ((cyclelimit - used) < slice)) {
+		slice = cyclelimit - used;
+	}
+	if (limited && (instrlimit != 0)) {
+		/* in s cycles, at most 2s instructions run, since only a
+		   short instruction in the low half of a word takes no
+		   cycle; with none left to spare, go one at a time */
+		uint64_t left = instrlimit - (hm->instructions - startinstr);
+		if ((left / 2) < slice) slice = (WORD)(left / 2);
+	}
+	hm->morecycles += hm->cycles + slice;
+	hm->cycles = -slice; /* next call when it's positive */
+}
@@ -0,0 +1,36 @@
+/* File: batch.h
+   Date: Oct. 16, 2026
+   Language: C (UNIX)
+   Purpose: Hawk Emulator, interface to the batch mode console
+*/
+
+/* assumes prior inclusion of <stdint.h> and "bus.h" */
+
+/***********************
+ * batch mode console  *
+ ***********************/
+
+/* with -b, console.c hands all of its work to these; there is no
+   curses front panel, the memory mapped display is kept in memory and
+   the keyboard is never ready.  The program runs from power up until
+   PC = 0, PC = the breakpoint or cyclelimit or instrlimit is reached,
+   then the display, the final registers, the cycle count, the count of
+   instructions and the speed in MIPS are put to stdout, and the
+   emulator exits, with EXIT_FAILURE if a limit stopped it.  The limits
+   count from the start of the run, which need not be power up if a
+   snapshot was restored; if a snapshot file was named, a snapshot is
+   saved on reaching the breakpoint.
+*/
+
+void batch_dispwrite( struct hawk_machine * hm, WORD addr, WORD val );
+WORD batch_dispread( struct hawk_machine * hm, WORD addr );
+void batch_kbdwrite( struct hawk_machine * hm, WORD addr, WORD val );
+WORD batch_kbdread( struct hawk_machine * hm, WORD addr );
+/* the memory mapped display and keyboard, as in console.h */
+
+void batch_startup();
+/* startup, called from console_startup */
+
+void batch_console( struct hawk_machine * hm );
+/* called from console whenever the console would have been, for the
+   machine hm it was called for, see machine.h */
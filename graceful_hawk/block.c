@@ -0,0 +1,165 @@
+/* File: block.c
+   Date: Oct. 16, 2026
+   Language: C (UNIX)
+   Purpose: Hawk Emulator, basic block translator;
+		runs of predecoded instructions are copied into arrays of
+		micro-ops, with their memory cycles counted in advance,
+		for the block engine in cpu.c.
+*/
+
+#include <inttypes.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "bus.h"
+#include "decode.h"
+#include "block.h"
+#include "mmu.h"
+#include "machine.h"
+
+/*************************
+ * the block cache       *
+ *************************/
+
+/* all micro-ops of a machine live in one arena, hm->uops, with
+   hm->nuops of them in use; when it fills up, every block is forgotten
+   and translation starts over from the bottom.  The arena is allocated
+   by the first block_flushall, so until then, hm->btab was never
+   flushed */
+#define BLOCKMAX 32     /* most instructions in one block */
+#define UOPS     16384  /* size of the micro-op arena */
+
+/* how an instruction behaves in a block */
+#define BODY 0  /* may be followed by more of the block */
+#define LAST 1  /* transfers control, so it ends the block */
+#define STEP 2  /* must not be in a block */
+
+static int kind( struct decoded * d ) {
+	/* classify the predecoded instruction d */
+	switch (d->op) {
+	case 0xFD: /* LOADS */
+	case 0xF5: /* LOAD */
+	case 0xE0: /* LIL */
+		return (d->dst == 0) ? LAST : BODY; /* to PC? */
+
+	case 0xFB: /* JSRS */
+	case 0xF3: /* JSR */
+	case 0x1D: /* BTRUNC */
+	case 0x00: /* Bcc */
+		return LAST;
+
+	case 0xF8: /* STOREC, store is conditional */
+	case 0xF1: /* -- */
+	case 0xF0: /* -- */
+	case 0x18: /* -- */
+	case 0x13: /* COGET */
+	case 0x12: /* COSET */
+	case 0x11: /* CPUGET */
+	case 0x10: /* CPUSET */
+	case OP_BUSFETCH:
+		return STEP;
+	}
+	return BODY;
+}
+
+static WORD memrefs( struct decoded * d ) {
+	/* memory cycles used by d, counting the load or store, if any */
+	switch (d->op) {
+	case 0xFD: /* LOADS */
+	case 0xFC: /* LOADSCC */
+	case 0xFA: /* STORES */
+	case 0xF9: /* LOADL */
+	case 0xF5: /* LOAD */
+	case 0xF4: /* LOADCC */
+	case 0xF2: /* STORE */
+		return d->fetches + 1;
+	}
+	return d->fetches;
+}
+
+/*************
+ * Interface *
+ *************/
+
+void block_flushall( struct hawk_machine * hm ) {
+	/* forget all translated blocks; this must be called once before
+	   the first use of BLOCK, and is cheap if nothing was translated */
+	int i;
+	if (hm->uops == NULL) { /* never flushed */
+		hm->uops = malloc( sizeof( struct uop ) * UOPS );
+		if (hm->uops == NULL) {
+			fputs( progname, stderr );
+			fputs( ": out of memory for blocks\n", stderr );
+			exit( EXIT_FAILURE ); /* error */
+		}
+	} else if (hm->nuops == 0) return;
+	for (i = 0; i < (1 << BHASHBITS); i++) hm->btab[i].start = ~(WORD)0;
+	hm->nuops = 0;
+}
+
+void block_flush( struct hawk_machine * hm, WORD a ) {
+	/* forget the blocks that hold any part of the decode page of m[a] */
+	WORD lo = a & ~(WORD)((1 << DPAGEBITS) - 1);
+	WORD hi = lo + (1 << DPAGEBITS);
+	int i;
+	if (hm->nuops == 0) return;
+	for (i = 0; i < (1 << BHASHBITS); i++) {
+		struct block * b = &hm->btab[i];
+		if ((b->start < hi) && (b->end > lo)) b->start = ~(WORD)0;
+	}
+}
+
+void block_free( struct hawk_machine * hm ) {
+	/* give back the micro-op arena */
+	free( hm->uops );
+	hm->uops = NULL;
+	hm->nuops = 0;
+}
+
+struct block * block_fill( struct hawk_machine * hm, WORD a ) {
+	/* translate the block starting at m[a], a < memsize, into btab */
+	struct block * b = &hm->btab[BHASH(a)];
+	struct uop * u;
+	WORD cyc = 0;   /* memory cycles so far */
+	int n = 0;      /* instructions so far */
+
+	/* make room for the biggest possible block */
+	if (hm->nuops > (UOPS - (BLOCKMAX + 1))) {
+		block_flushall( hm );
+	}
+	b->start = a;
+	b->u = u = &hm->uops[hm->nuops];
+	b->native = NULL;
+	b->count = 0;
+
+	for (;;) {
+		struct decoded * d = DECODED( hm, a );
+		int k = kind( d );
+		if (k == STEP) {
+			if (n == 0) { /* a block of one, run it the slow way */
+				u->d = *d;
+				u->d.op = OP_STEP;
+				u->cyc = 0;
+				u++;
+				a += d->len;
+			}
+			break;
+		}
+		u->d = *d;
+		u->cyc = cyc;
+		u++;
+		cyc += memrefs( d );
+		a += d->len;
+		n++;
+		if ((k == LAST) || (n == BLOCKMAX)) break;
+	}
+	if (n > 0) {
+		u->d.op = OP_END;
+		u->d.imm = cyc;
+		u->cyc = cyc;
+		u++;
+	}
+	b->end = a;
+	hm->nuops = u - hm->uops;
+	return b;
+}
@@ -0,0 +1,65 @@
+/* File: block.h
+   Date: Oct. 16, 2026
+   Language: C (UNIX)
+   Purpose: Hawk Emulator, interface to the basic block translator
+*/
+
+/* assumes prior inclusion of <stdint.h>, "bus.h" and "decode.h" */
+
+/********************************
+ * translated basic blocks      *
+ ********************************/
+
+/* a basic block is a run of predecoded instructions that starts
+   wherever control arrives and ends with the first transfer of control;
+   it is translated once into an array of micro-ops that the block
+   engine in cpu.c runs without checking for interrupts, breakpoints or
+   display updates between instructions.
+
+   each micro-op is a copy of the instruction's decoded record, with
+   the memory cycles used by the block before that instruction; the
+   last micro-op of every block is an OP_END whose imm is the memory
+   cycle count of the whole block, charged once when the block is done.
+   Instructions that need exact per-instruction treatment (traps,
+   CPUGET, CPUSET, coprocessor access and STOREC) are never put in
+   a block; a block that would start with one is a single OP_STEP.
+*/
+struct uop {
+	struct decoded d; /* the instruction, or OP_END or OP_STEP */
+	WORD cyc;         /* memory cycles used by the block before this */
+};
+
+/* pseudo-op keys for block control, beyond those in decode.h */
+#define OP_END  (NUMOPS + 0) /* end of block, imm is cycles for block */
+#define OP_STEP (NUMOPS + 1) /* run the instruction by the slow path */
+
+struct block {
+	WORD start;       /* address of the first instruction */
+	WORD end;         /* address just beyond the last instruction */
+	struct uop * u;   /* the first micro-op */
+	void * native;    /* host code for the block, see jit.h, or NULL */
+	WORD count;       /* times the block was entered, up to JIT_HOT */
+};
+
+/* blocks are found by a direct mapped hash on their start address;
+   when two blocks collide, the newer replaces the older.  Each machine
+   has a table of its own, hm->btab, and the micro-ops of its blocks,
+   see machine.h */
+#define BHASHBITS 12
+#define BHASH(a) (((a) >> 1) & ((1 << BHASHBITS) - 1))
+
+/* get the block starting at a on machine h, with a < memsize */
+#define BLOCK(h,a) ( ((h)->btab[BHASH(a)].start == (a))		\
+		   ? &(h)->btab[BHASH(a)] : block_fill( h, a ) )
+
+struct block * block_fill( struct hawk_machine * hm, WORD a );
+/* translate the block starting at m[a], a < memsize, into hm->btab */
+
+void block_flush( struct hawk_machine * hm, WORD a );
+/* forget the blocks that hold any part of the decode page of m[a] */
+
+void block_flushall( struct hawk_machine * hm );
+/* forget all translated blocks, must be called before the first BLOCK */
+
+void block_free( struct hawk_machine * hm );
+/* give back what block_flushall allocated for hm */
@@ -5,6 +5,13 @@
    Revised: Aug 21, 2011 -- add interface to floating point coprocessor
    Revised: Nov  8, 2023 -- minor changes to coprocessor masks, (WORD)casting
    Revised: Dec 11, 2023 -- interrupt support
+   Revised: Oct 16, 2026 -- batch mode and snapshot support
+   Revised: Oct 16, 2026 -- memory size set at powerup
+   Revised: Oct 16, 2026 -- memory management unit, see mmu.h
+   Revised: Oct 16, 2026 -- per core state for multiprocessors, see smp.h
+   Revised: Oct 16, 2026 -- machine state moved to machine.h
+   Revised: Oct 16, 2026 -- fork server support
+   Revised: Oct 16, 2026 -- profiler support
    Language: C (UNIX)
    Purpose:
 	Declarations of bus lines shared by the hawk CPU and peripherals.
@@ -26,6 +33,12 @@
 #define EXTERN extern
 #endif
 
+/* the registers, memory and everything else that belongs to one Hawk
+   machine are fields of a struct hawk_machine, see machine.h; what is
+   declared here is shared by all of the machines in the process
+*/
+struct hawk_machine;
+
 
 /*********************/
 /* Hawk data formats */
@@ -45,20 +58,70 @@
  */
 #define NAME_LENGTH 120
 
-/* count of memory cycles; cycles is incremented with every memory
-   reference and causes console interrupts.  the sum cycles+morecycles
-   is the true cycle count.  recycle determines frequency of console update
+/* count of memory cycles; the cycles field of each machine is
+   incremented with every memory reference and causes console interrupts.
+   recycle determines how often, in memory cycles, the running console
+   looks to see if a display update is due; framerate determines how
+   often, in updates per second of host time, one is due
  */
-EXTERN WORD cycles;
-EXTERN WORD morecycles;
 EXTERN WORD recycle;
+EXTERN WORD framerate;
+
+/* batch mode, set by powerup from -b, -C and -I; the program runs
+   without the console until it stops or a nonzero limit is reached,
+   see batch.h
+ */
+EXTERN int batch;
+EXTERN WORD cyclelimit;
+EXTERN uint64_t instrlimit;
+
+/* snapshots, see snapshot.h; snapname is set by powerup from -S, and
+   restored is set when powerup restores a snapshot from -R
+ */
+EXTERN char * snapname;
+EXTERN int restored;
 
-/* memory address compared with pc to stop cpu at breakpoints
+/* the fork server, see forkserver.h; forkname is set by powerup from
+   -F, and workers, how many jobs run at once, from -j, as for -J
  */
-EXTERN WORD breakpoint;
+EXTERN char * forkname;
+EXTERN int workers;
+
+/* the profiler, see profile.h; profname is set by powerup from -p,
+   foldname from -g, timename from -T and listname from -L
+ */
+EXTERN char * profname;
+EXTERN char * foldname;
+EXTERN char * timename;
+EXTERN char * listname;
+
+/* the instruction trace, see itrace.h; itracename is set by powerup
+   from -X
+ */
+EXTERN char * itracename;
+
+/* the cache simulator, see cache.h; l1iname is set by powerup from -i
+   and l1dname from -d
+ */
+EXTERN char * l1iname;
+EXTERN char * l1dname;
 
 extern int animation_mode;
 
+/* which execution engine the cpu runs, set by powerup from -E
+ */
+EXTERN int engine;
+#define ENGINE_SWITCH   0 /* one switch dispatches every instruction */
+#define ENGINE_THREADED 1 /* each instruction dispatches the next one */
+#define ENGINE_BLOCK    2 /* basic blocks run without interruption */
+#define ENGINE_JIT      3 /* hot basic blocks run as host code, see jit.h */
+
+/* the number of CPUs sharing memory, set by powerup from -P; ncores
+   is 1 unless built with SMP
+ */
+#define MAXCORES 64
+EXTERN int ncores;
+
 /*****************************************************/
 /* Globals that really aren't really part of the bus */
 /*****************************************************/
@@ -71,17 +134,19 @@ EXTERN char * progname; /* name of program itself (argv[0]) */
 /**********/
 
 /* This emulator does not allow for non-contiguous memory fields.
-   Memory runs from 0 to MAXMEM-1; MAXMEM should be a multiple of 0x10000,
-   and should never be as great as 0xFFFF0000 (a highly unlikely limitation).
-   Memory from location 0 to MAXROM-1 is read-only and may not be modified
-   at run-time; MAXROM should be a multiple of 0x10000.
+   Memory runs from 0 to memsize-1; memsize must be a multiple of 0x10000,
+   and must be below IOSPACE.
+   Memory from location 0 to romsize-1 is read-only and may not be modified
+   at run-time; romsize must be a multiple of 0x10000.
 */
 
-/* MAXMEM is specified in bytes and provided by Makefile */
-/* MAXROM is specified in bytes and provided by Makefile */
+/* MAXMEM is the default memsize in bytes and provided by Makefile */
+/* MAXROM is the default romsize in bytes and provided by Makefile */
+/* both may be changed from the command line, see powerup.c */
 
-/* note that memory is word addressable */
-EXTERN WORD m[ MAXMEM >> 2 ];
+/* note that memory is word addressable; powerup reserves memsize bytes
+   for it, and the host gives pages to it only as they are touched.
+   m, memsize and romsize are fields of the machine, see machine.h */
 
 /* memory mapped I/O owns the top 16 meg of the address space */
 #define IOSPACE   0xFF000000UL
@@ -123,7 +188,7 @@ EXTERN WORD m[ MAXMEM >> 2 ];
 /* Trap and Interrupt Vectoring */
 /********************************/
 
-/* All trap addresses must be less than MAXMEM!
+/* All trap addresses must be less than memsize!
 */
 
 #define RESTART_TRAP      (WORD)0x00000000UL  /* on powerup */
@@ -137,22 +202,31 @@ EXTERN WORD m[ MAXMEM >> 2 ];
 
 #define TRAP_VECTOR_STEP  (WORD)0x00000010UL  /* spacing of vector entries*/
 
+/************************/
+/* Performance Counters */
+/************************/
+
+/* CPUGET x,n gets performance counter n of the core that runs it, and
+   CPUSET x,n sets it to x, so that a program can time its own parts;
+   each counts from 0 at reset and wraps around after 0xFFFFFFFF.  They
+   are always on, and count the same in every execution engine.
+*/
+#define CNTINSTR  0x9 /* instructions, including any that trapped */
+#define CNTBRANCH 0xA /* branches taken, jumps, calls, returns from trap */
+#define CNTLOAD   0xB /* loads, from memory or I/O space */
+#define CNTSTORE  0xC /* stores, to memory or I/O space, and STOREC */
+#define CNTTRAP   0xD /* traps, not counting interrupts */
+#define CNTINTR   0xE /* interrupts */
+#define CNTCOP    0xF /* COGET and COSET */
+
 /*******************************/
 /* Generally visible registers */
 /*******************************/
 
-/* All of the following are visible outside the CPU in some context or
-   another, either to some I/O device or to the front panel.
+/* r, pc, costat, cocc, psw, tpc, tma, tsv and irq are visible outside
+   the CPU in some context or another, either to some I/O device or to
+   the front panel; they are fields of the machine, see machine.h
 */
-EXTERN WORD r[16];  /* the general purpose registers */
-EXTERN WORD pc;     /* the program counter */
-EXTERN WORD costat; /* the coprocessor status register */
-EXTERN WORD cocc;   /* condition codes set by coprocessor for COGET */
-EXTERN WORD psw;    /* the processor status word */
-EXTERN WORD tpc;    /* saved pc after a trap */
-EXTERN WORD tma;    /* saved memory address after a trap */
-EXTERN WORD tsv;    /* trap save location */
-EXTERN WORD irq;    /* interrupt request */
 
 /* costat fields
 */
@@ -173,6 +247,7 @@ EXTERN WORD irq;    /* interrupt request */
 #define CBITS (WORD)0x0000FF00UL
 #define LEVEL (WORD)0xF0000000UL
 #define OLEVEL (WORD)0x0F000000UL
+#define MMUON  (WORD)0x80000000UL  /* top bit of LEVEL, see mmu.h */
 
 /* priority interrupt scheme
    there are several ways to make the level field establish interrupt priority.
@@ -197,3 +272,20 @@ EXTERN WORD irq;    /* interrupt request */
 #define IRQ6  (WORD)0x00000040UL
 #define IRQ7  (WORD)0x00000080UL
 
+/* each core has its own irq; devices request interrupts with RAISE
+   and retract them with RETRACT.  With one core, these change the irq
+   of hm, the machine the device was called for; with SMP, they change
+   the irq of core 0, and other cores may change irq at the same time,
+   see smp.h, so they are atomic
+*/
+#ifdef SMP
+EXTERN WORD * irqs[MAXCORES]; /* the irq of each core */
+#define RAISEON(c,bits)   __atomic_fetch_or( irqs[c], bits, __ATOMIC_RELAXED )
+#define RETRACTON(c,bits) __atomic_fetch_and( irqs[c], ~(WORD)(bits), \
+					      __ATOMIC_RELAXED )
+#else
+#define RAISEON(c,bits)   (hm->irq |= (bits))
+#define RETRACTON(c,bits) (hm->irq &= ~(WORD)(bits))
+#endif
+#define RAISE(bits)   RAISEON( 0, bits )
+#define RETRACT(bits) RETRACTON( 0, bits )
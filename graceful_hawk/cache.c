@@ -0,0 +1,205 @@
+/* File: cache.c
+   Date: Oct. 16, 2026
+   Language: C (UNIX)
+   Purpose: Hawk Emulator, cache simulator;
+		follows which lines L1 instruction and data caches would
+		hold, and counts their hits, misses and writebacks.
+*/
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "bus.h"
+#include "decode.h"
+#include "block.h"
+#include "mmu.h"
+#include "machine.h"
+#include "cache.h"
+
+static struct l1cache * l1i = NULL; /* the caches of the machine, */
+static struct l1cache * l1d = NULL; /* for the report at exit */
+
+static void fail( const char * option, const char * spec, const char * why ) {
+	fputs( progname, stderr );
+	fputs( option, stderr );
+	fputs( spec, stderr );
+	fputs( why, stderr );
+	exit( EXIT_FAILURE ); /* error */
+}
+
+/*****************
+ * lookup        *
+ *****************/
+
+WORD l1_access( struct l1cache * c, WORD a, int write ) {
+	WORD line = (a >> c->linebits) + 1; /* never 0, the empty tag */
+	int base = (int)((line - 1) & c->setmask) * c->ways;
+	WORD * tag = &c->tag[base];
+	int i, victim;
+
+	c->clock++;
+	for (i = 0; i < c->ways; i++) {
+		if (tag[i] == line) { /* hit */
+			c->hits[write]++;
+			if (c->policy == L1LRU) c->used[base + i] = c->clock;
+			if (write) c->dirty[base + i] = 1;
+			return 0;
+		}
+	}
+
+	/* miss, fill an empty way, or replace one */
+	c->misses[write]++;
+	victim = 0;
+	for (i = 0; i < c->ways; i++) {
+		if (tag[i] == 0) break;
+	}
+	if (i < c->ways) {
+		victim = i;
+	} else if (c->policy == L1RANDOM) {
+		c->seed ^= c->seed << 13; /* xorshift */
+		c->seed ^= c->seed >> 17;
+		c->seed ^= c->seed << 5;
+		victim = c->seed & (c->ways - 1);
+	} else { /* the oldest, by fill for fifo, by use for lru */
+		for (i = 1; i < c->ways; i++) {
+			if ((uint32_t)(c->clock - c->used[base + i])
+			>   (uint32_t)(c->clock - c->used[base + victim])) {
+				victim = i;
+			}
+		}
+	}
+	if (c->dirty[base + victim]) c->writebacks++;
+	tag[victim] = line;
+	c->used[base + victim] = c->clock;
+	c->dirty[base + victim] = write;
+	return c->penalty;
+}
+
+WORD l1_fetch( struct l1cache * c, WORD a, int len ) {
+	WORD cost = l1_access( c, a, L1READ );
+	if (((a ^ (a + len - 1)) >> c->linebits) != 0) { /* spans two lines */
+		cost += l1_access( c, a + len - 1, L1READ );
+	}
+	return cost;
+}
+
+/*****************
+ * the report    *
+ *****************/
+
+static void counts( const char * what, uint64_t hits, uint64_t misses ) {
+	uint64_t all = hits + misses;
+	fprintf( stderr, "  %-8s %12"PRIu64" hits %12"PRIu64" misses", what,
+		 hits, misses );
+	if (all > 0) {
+		fprintf( stderr, "  %6.2f%% missed", 100.0 * misses / all );
+	}
+	fputc( '\n', stderr );
+}
+
+static void describe( const char * name, struct l1cache * c ) {
+	static const char * const policies[] = { "lru", "fifo", "random" };
+	int sets = c->setmask + 1;
+	fprintf( stderr, "%s %d bytes, %d way, %d byte lines, %s, penalty %"
+		 PRIu32"\n", name, (sets * c->ways) << c->linebits, c->ways,
+		 1 << c->linebits, policies[c->policy], c->penalty );
+}
+
+static void finish() {
+	/* called at exit, report on each cache */
+	if (l1i != NULL) {
+		describe( "L1 I cache:", l1i );
+		counts( "fetches", l1i->hits[L1READ], l1i->misses[L1READ] );
+	}
+	if (l1d != NULL) {
+		describe( "L1 D cache:", l1d );
+		counts( "loads", l1d->hits[L1READ], l1d->misses[L1READ] );
+		counts( "stores", l1d->hits[L1WRITE], l1d->misses[L1WRITE] );
+		fprintf( stderr, "  %-8s %12"PRIu64"\n", "written",
+			 l1d->writebacks );
+	}
+}
+
+/*****************
+ * starting      *
+ *****************/
+
+static int log2of( WORD n ) {
+	/* log2 of n, or -1 if n is not a power of two */
+	int b = 0;
+	if ((n == 0) || (n & (n - 1))) return -1;
+	while ((n >> b) != 1) b++;
+	return b;
+}
+
+static WORD number( const char * option, const char * spec, char * f ) {
+	/* the field f of spec, in decimal or 0x hex */
+	char * e;
+	WORD n = (WORD)strtoul( f, &e, 0 );
+	if ((e == f) || (*e != '\0')) fail( option, spec, ": bad number\n" );
+	return n;
+}
+
+static struct l1cache * make( const char * option, const char * spec ) {
+	/* make the cache described by spec, see cache.h, for option */
+	struct l1cache * c = calloc( 1, sizeof( struct l1cache ) );
+	char * fields = strdup( spec );
+	char * f;
+	WORD n[4]; /* bytes, ways, line and penalty */
+	int i, sets;
+
+	if ((c == NULL) || (fields == NULL)) {
+		fail( option, spec, ": out of memory\n" );
+	}
+	c->spec = spec;
+	c->policy = L1LRU;
+	n[3] = 0;
+	i = 0;
+	for (f = strtok( fields, "," ); f != NULL; f = strtok( NULL, "," )) {
+		if (i >= 5) {
+			fail( option, spec, ": bad cache\n" );
+		} else if (i < 3) { /* bytes, ways and line come first */
+			n[i] = number( option, spec, f );
+		} else if (!strcmp( f, "lru" )) {
+			c->policy = L1LRU;
+		} else if (!strcmp( f, "fifo" )) {
+			c->policy = L1FIFO;
+		} else if (!strcmp( f, "random" )) {
+			c->policy = L1RANDOM;
+		} else {
+			n[3] = number( option, spec, f );
+		}
+		i++;
+	}
+	free( fields );
+	if (i < 3) fail( option, spec, ": needs bytes,ways,line\n" );
+
+	c->ways = (int)n[1];
+	c->linebits = log2of( n[2] );
+	c->penalty = n[3];
+	if ((log2of( n[0] ) < 0) || (log2of( n[1] ) < 0) || (c->linebits < 2)
+	||  (n[1] > 256) || (n[0] < (n[1] * n[2]))) {
+		fail( option, spec,
+		      ": bytes, ways and line must be powers of two,"
+		      " line at least 4, ways at most 256,"
+		      " and bytes at least ways times line\n" );
+	}
+	sets = (int)(n[0] / (n[1] * n[2]));
+	c->setmask = sets - 1;
+	c->seed = 0x2545F491;
+	c->tag = calloc( sets * c->ways, sizeof( WORD ) );
+	c->used = calloc( sets * c->ways, sizeof( uint32_t ) );
+	c->dirty = calloc( sets * c->ways, sizeof( BYTE ) );
+	if ((c->tag == NULL) || (c->used == NULL) || (c->dirty == NULL)) {
+		fail( option, spec, ": out of memory\n" );
+	}
+	return c;
+}
+
+void l1_start( struct hawk_machine * hm, const char * icache,
+	       const char * dcache ) {
+	if (icache != NULL) l1i = hm->l1i = make( " -i ", icache );
+	if (dcache != NULL) l1d = hm->l1d = make( " -d ", dcache );
+	atexit( finish );
+}
@@ -0,0 +1,71 @@
+/* File: cache.h
+   Date: Oct. 16, 2026
+   Language: C (UNIX)
+   Purpose: Hawk Emulator, interface to the cache simulator
+*/
+
+/* assumes prior inclusion of <stdint.h>, "bus.h" and "machine.h" */
+
+/*****************
+ * the caches    *
+ *****************/
+
+/* built with CACHE, see the Makefile, -i cache and -d cache give core 0
+   an L1 instruction cache and an L1 data cache, each described as
+
+	bytes,ways,line[,policy][,penalty]
+
+   for a cache of bytes bytes, ways way set associative, with lines of
+   line bytes, all powers of two, replacing the least recently used line
+   of a set (lru, the default), the one filled first (fifo) or any one
+   (random).  Every instruction fetched from memory looks in the L1 I
+   cache, twice if it spans two lines, and every load and store of
+   memory looks in the L1 D cache, by physical address; I/O space is
+   never cached, and the caches hold no data, only which lines they
+   would hold.  Stores allocate lines and make them dirty, and a dirty
+   line written back when it is replaced is counted.  Each miss costs
+   penalty more memory cycles, 0 by default, so that by default the
+   caches only count and the program runs as it would without them.
+   The block engine and the JIT do not run one instruction at a time,
+   so with -i or -d the switch engine runs in their place.
+
+   when the emulator exits, the hits and misses of each cache are
+   written to stderr.  Without -i and -d, each fetch, load and store
+   costs one compare; without CACHE, nothing.
+*/
+struct l1cache {
+	WORD * tag;        /* sets * ways, line number + 1, or 0 if empty */
+	uint32_t * used;   /* when each was filled or, for lru, last hit */
+	BYTE * dirty;      /* nonzero if stored into since it was filled */
+	WORD setmask;      /* sets - 1 */
+	int linebits;      /* log2 of the line size */
+	int ways;
+	int policy;        /* L1LRU, L1FIFO or L1RANDOM */
+	WORD penalty;      /* added to cycles for each miss */
+	uint32_t clock;    /* counts accesses, for used */
+	uint32_t seed;     /* for L1RANDOM */
+
+	uint64_t hits[2];  /* by L1READ or L1WRITE */
+	uint64_t misses[2];
+	uint64_t writebacks;
+	const char * spec; /* as given to -i or -d */
+};
+
+#define L1LRU    0
+#define L1FIFO   1
+#define L1RANDOM 2
+
+#define L1READ   0
+#define L1WRITE  1
+
+WORD l1_access( struct l1cache * c, WORD a, int write );
+/* look up the word at physical address a, a < memsize; returns the
+   cycles it costs over a hit */
+
+WORD l1_fetch( struct l1cache * c, WORD a, int len );
+/* look up the instruction len bytes long at physical address a */
+
+void l1_start( struct hawk_machine * hm, const char * icache,
+	       const char * dcache );
+/* called from main once powerup is done; give hm the caches described
+   by icache and dcache, unless they are NULL */
@@ -8,11 +8,20 @@
    Revised: Aug. 24, 2008 - flip byte order in IR, add n console command
    Revised: Nov.  8, 2023 - added display of costat, fp accumulators
    Revised: Dec. 11, 2023 - make interrupts work, make polling KBDSTAT polite
+   Revised: Oct. 16, 2026 - hand everything to batch.c in batch mode
+   Revised: Oct. 16, 2026 - add k command to save a snapshot
+   Revised: Oct. 16, 2026 - keyboard interrupts core 0, add console_running
+   Revised: Oct. 16, 2026 - show the machine console() is given
+   Revised: Oct. 16, 2026 - pace display updates by host time, see framerate
+   Revised: Oct. 16, 2026 - keep the display in memory, draw it on a thread
+   Revised: Oct. 16, 2026 - draw only the changed part of the display
+   Revised: Oct. 16, 2026 - draw hex numbers and the display as runs of cells
 
    Language: C (UNIX) with -lcurses option
    Purpose: Hawk Emulator console support;
 */
 #include <time.h>
+#include <errno.h>
 #include <string.h>
 #include <stdarg.h>
 #include <inttypes.h>
@@ -20,12 +29,22 @@
 #include <stdlib.h>
 #include <curses.h>
 #include <signal.h>
+#include <sys/time.h>
+#ifdef RENDER
+#include <pthread.h>
+#endif
 /*#include <sys/ioctl.h>*/
 #include "graceful_hawk.h"
 #include "bus.h"
 #include "float.h"
+#include "decode.h"
+#include "block.h"
+#include "mmu.h"
+#include "machine.h"
 #include "showop.h"
 #include "console.h"
+#include "batch.h"
+#include "snapshot.h"
 
 /*****************
  * screen layout *
@@ -86,6 +105,20 @@ int broken = FALSE;
 /* cycle count value seen at time of break */
 WORD breakcycles = 0;
 
+/* set by console_tick framerate times a second, cleared by each update */
+static volatile sig_atomic_t framedue = FALSE;
+
+static void doze(long nsec) {
+	/* sleep for nsec nanoseconds; console_tick interrupts nanosleep
+	   framerate times a second, so sleep on for what is left */
+	struct timespec tim;
+	tim.tv_sec = nsec / 1000000000L;
+	tim.tv_nsec = nsec % 1000000000L;
+	while (nanosleep(&tim, &tim) != 0) {
+		if (errno != EINTR) break;
+	}
+}
+
 /* number being entered */
 WORD number = 0;
 
@@ -101,7 +134,7 @@ WORD dump_mode = CODEMODE;
 /*************************
  * Symbolic Dump Support *
  *************************/
-static void change_dump_mode();
+static void change_dump_mode(struct hawk_machine * hm);
 
 /*******************
  * console display *
@@ -143,39 +176,39 @@ static void title() {
 }
 
 
-static void status() {
-	/* display CPU status on screen */
+static void status(struct hawk_machine * hm) {
+	/* display CPU status of hm on screen */
 	char n,z,v,c;
 	int i;
 	n = z = v = c = '0';
-	if (psw & N) n = '1'; 
-	if (psw & Z) z = '1'; 
-	if (psw & V) v = '1'; 
-	if (psw & C) c = '1'; 
+	if (hm->psw & N) n = '1'; 
+	if (hm->psw & Z) z = '1'; 
+	if (hm->psw & V) v = '1'; 
+	if (hm->psw & C) c = '1'; 
 	move(pcy, pcx);                             /* 0123456789012345 */
 	printw_c(p_status_text, "PC:  ");               /* PC:  00000000 */
-	printw_c(p_status_num, "%08"PRIX32, pc);               /* PC:  00000000 */
+	printw_c(p_status_num, "%08"PRIX32, hm->pc);         /* PC:  00000000 */
 	move(pcy + 1, pcx);
 	printw_c(p_status_text, "PSW: ");              /* PSW: 00000000 */
-	printw_c(p_status_num, "%08"PRIX32, psw);              /* PSW: 00000000 */
+	printw_c(p_status_num, "%08"PRIX32, hm->psw);        /* PSW: 00000000 */
 	move(pcy + 2, pcx);
 	printw_c(p_status_text, "NZVC: ");    /* NZVC: 0 0 0 0 */
 	printw_c(p_status_num, "%c %c %c %c", n, z, v, c);    /* NZVC: 0 0 0 0 */
-	if (costat & COENAB) {
+	if (hm->costat & COENAB) {
 		move(pcy + 4, pcx);
 		printw_c(p_status_text, "COSTAT: ");/* COSTAT: 0000  */
-		printw_c(p_status_num, "%04"PRIX32, costat);/* COSTAT: 0000  */
+		printw_c(p_status_num, "%04"PRIX32, hm->costat);/* COSTAT: 0000  */
 	} else {
 		move(pcy + 4, pcx);
 		printw("             ");            /*     erase     */
 	}
-	if (costat & COFPENAB) {
+	if (hm->costat & COFPENAB) {
 		move(pcy + 5, pcx);
 		printw_c(p_status_text, "/----FPU----\\");           /* /----FPU----\ */
 		move(pcy + 6, pcx);
-		printw("A0: %9.3g", float_acc(0));  /* A0: 0.000E000 */
+		printw("A0: %9.3g", float_acc(hm, 0));  /* A0: 0.000E000 */
 		move(pcy + 7, pcx);
-		printw("A1: %9.3g", float_acc(1));  /* A1: 0.000E000 */
+		printw("A1: %9.3g", float_acc(hm, 1));  /* A1: 0.000E000 */
 	} else {
 		move(pcy + 5, pcx);
 		printw("             ");            /*     erase     */
@@ -188,9 +221,9 @@ static void status() {
 		move(pcy + i, pcx + 15);
 		printw_c(p_register_text, "R%1X: ", i);
 		if (cn_on){
-			print_colorful_nums(r[i]);
+			print_colorful_nums(hm->r[i]);
 		} else {
-			printw_c(p_register_num, "%08" PRIX32, r[i]);
+			print_plain_nums(hm->r[i], p_register_num);
 		}
 		 
 	}
@@ -198,9 +231,9 @@ static void status() {
 		move(pcy + (i - 8), pcx + 29);
 		printw_c(p_register_text, "R%1X: ", i);
 		if (cn_on){
-			print_colorful_nums(r[i]);
+			print_colorful_nums(hm->r[i]);
 		} else {
-			printw_c(p_register_num, "%08" PRIX32, r[i]);
+			print_plain_nums(hm->r[i], p_register_num);
 		}
 		// printw_c(p_register_num, "%08"PRIX32, r[i]);
 
@@ -208,8 +241,8 @@ static void status() {
 }
 
 
-static void dump() {
-	/* display memory on screen */
+static void dump(struct hawk_machine * hm) {
+	/* display memory of hm on screen */
         unsigned int i;
 	if (COLS < (dumpx + 18)) return; /* no space on screen */
 	if (dump_mode == DATAMODE) { /* do a hex dump */
@@ -217,24 +250,24 @@ static void dump() {
 		for (i = 0; i < 8; i += 1) {
 			WORD addr = dump_addr + (i<<2);
 			move(dumpy + i, dumpx);
-			if (addr == (pc & 0xFFFFFFFCUL)) {
-				if (addr == (breakpoint & 0xFFFFFFFCUL)) {
+			if (addr == (hm->pc & 0xFFFFFFFCUL)) {
+				if (addr == (hm->breakpoint & 0xFFFFFFFCUL)) {
 					addstr("-*");
 				} else {
 					addstr("->");
 				}
 			} else {
-				if (addr == (breakpoint & (WORD)0xFFFFFFFCUL)) {
+				if (addr == (hm->breakpoint & (WORD)0xFFFFFFFCUL)) {
 					addstr(" *");
 				} else {
 					addstr("  ");
 				}
 			}
-			if (addr < MAXMEM) {
-				WORD data = m[addr>>2];
+			if (addr < hm->memsize) {
+				WORD data = hm->m[addr>>2];
 				printw_c(p_memory_add, "%06"PRIX32": ", addr&(WORD)0x00FFFFFFUL)
 				if (!cn_on){
-					printw_c(p_memory_num, "%08" PRIX32, data);
+					print_plain_nums(data, p_memory_num);
 				} else {
 					print_colorful_nums(data);
 				}
@@ -264,24 +297,24 @@ static void dump() {
 			for (i = 0; i < 8; i += 1) {
 				addr &= (WORD)0x00FFFFFEUL;
 				move(dumpy + i, dumpx);
-				if (addr == pc) {
-					if (addr == breakpoint) {
+				if (addr == hm->pc) {
+					if (addr == hm->breakpoint) {
 						addstr("-*");
 					} else {
 						addstr("->");
 					}
 					pcnotseen = FALSE;
 				} else {
-					if (addr == breakpoint) {
+					if (addr == hm->breakpoint) {
 						addstr(" *");
 					} else {
 						addstr("  ");
 					}
 				}
-				if (addr < MAXMEM) {
+				if (addr < hm->memsize) {
 					printw_c(p_memory_add, "%06" PRIX32 ": ", addr & (WORD)0x00FFFFFFUL);
 					attron(COLOR_PAIR(p_memory_text));
-					addr += showop(addr); 
+					addr += showop(hm, addr); 
 					attroff(COLOR_PAIR(p_memory_text));
 				} else {
 					printw("%06"PRIX32": --",
@@ -291,7 +324,7 @@ static void dump() {
 				clrtoeol();
 			}
 			trial += 2;
-		} while (((dump_addr+trial) <= pc) && (pc < addr) && pcnotseen);
+		} while (((dump_addr+trial) <= hm->pc) && (hm->pc < addr) && pcnotseen);
 	}
 }
 
@@ -316,9 +349,9 @@ static void menu() {
 		"**HALTED**  0-9/A-F(enter n) p(run until pc=n)"
 			" <>(adjust n) ?(help)",
 		"**HALTED**  n(next)"
-			" i(iterate) ?(help)",
+			" i(iterate) k(keep snapshot) ?(help)",
 		"**HALTED**  0-9/A-F(enter n)"
-			" z(set refresh interval=n) ?(help)"
+			" z(set refresh rate=n per second) ?(help)"
 	};
 	move(menuy, menux);
 	if (running) {
@@ -337,46 +370,95 @@ static void menu() {
 
 static int dispend; /* the end address of the display memory */
 static int dispcols; /* the number of displayed columns */
+static int displines; /* the number of displayed lines */
+
+/* the display, one character per cell, dispcols by displines, as it
+   would read back from the screen; the CPU stores into it and whoever
+   draws the front panel copies it to the screen, see showdisp() */
+static BYTE * disp = NULL;
+
+/* the cells of a display changed since it was last drawn; on line y,
+   from lo[y] up to but not including hi[y], none if lo[y] >= hi[y] */
+struct dirty {
+	int * lo;
+	int * hi;
+};
+static struct dirty dispdirty; /* the changes to disp */
+
+static void touch(struct dirty * dd, int y, int from, int to) {
+	/* cells from to to-1 of line y changed */
+	if (from < dd->lo[y]) dd->lo[y] = from;
+	if (to > dd->hi[y]) dd->hi[y] = to;
+}
+
+static void touchall(struct dirty * dd) {
+	/* all the cells changed, so draw them all */
+	int y;
+	for (y = 0; y < displines; y++) touch(dd, y, 0, dispcols);
+}
 
-static void dispwrite_char(char c){
-	//adding this flag to see if we need to use attroff
-	//if there are non-hex chars to be printed, there is no need to attroff
-	bool color_set = false;
-	int color_index;
-	if (cn_on){
-		// for whatever reason, isxdigit() is not working on 'A' -'F'
-		if ('0' <= c && c <= '9') {
-			color_set = true;
-			color_index = p_nums + c - '0';
-			attron(COLOR_PAIR(color_index));
-		} else if ('A' <= c && c <= 'F') {
-			color_set = true;
-			color_index = p_nums + c - 'A' + 9;
-			attron(COLOR_PAIR(color_index));
+static void makedirty(struct dirty * dd) {
+	/* make dd, with nothing changed */
+	int y;
+	dd->lo = malloc(displines * sizeof(int));
+	dd->hi = malloc(displines * sizeof(int));
+	if ((dd->lo == NULL) || (dd->hi == NULL)) {
+		endwin();
+		fputs(progname, stderr);
+		fputs(": out of memory for the display\n", stderr);
+		exit(EXIT_FAILURE); /* error */
+	}
+	for (y = 0; y < displines; y++) {
+		dd->lo[y] = dispcols;
+		dd->hi[y] = 0;
+	}
+}
+
+static void showdisp(BYTE * d, struct dirty * dd) {
+	/* copy the cells of the display d changed in dd to the screen, each
+	   line's changes as one run of cells, see colorful_char() */
+	chtype run[dispcols];
+	int x, y;
+	for (y = 0; y < displines; y++) {
+		BYTE * line = &d[y * dispcols];
+		if (dd->lo[y] >= dd->hi[y]) continue;
+		for (x = dd->lo[y]; x < dd->hi[y]; x++) {
+			run[x - dd->lo[y]] = colorful_char(line[x]);
 		}
+		mvaddchnstr(dispy + y, dispx + dd->lo[y], run,
+			    dd->hi[y] - dd->lo[y]);
+		dd->lo[y] = dispcols;
+		dd->hi[y] = 0;
 	}
-	if (c >= ' ') {addch(c);} else {addch(c|'@');}
-	if (cn_on && color_set) attroff(COLOR_PAIR(color_index));
 }
-void dispwrite(WORD addr, WORD val) {
+
+void dispwrite(struct hawk_machine * hm, WORD addr, WORD val) {
 	/* addr is relative to display's address range */
 	/* val is value to display */
+	if (batch) {
+		batch_dispwrite(hm, addr, val);
+		return;
+	}
 	if (addr >= (DISPBASE + DISPSTART)) {
 		if (addr >= dispend) { 
 			return;
 		} else {
 			int relad = addr - (DISPBASE + DISPSTART);
-			int x = dispx + relad % dispcols;
-			int y = dispy + relad / dispcols;
-			char c0 =  val       & 0x7F;
-			char c1 = (val >> 8) & 0x7F;
-			char c2 = (val >>16) & 0x7F;
-			char c3 = (val >>24) & 0x7F;
-			move(y, x);
-			dispwrite_char(c0);
-			dispwrite_char(c1);
-			dispwrite_char(c2);
-			dispwrite_char(c3);
+			int y = relad / dispcols;
+			int x = relad % dispcols;
+			int i;
+			for (i = 0; i < 4; i++, x++) {
+				char c = (val >> (i << 3)) & 0x7F;
+				if (c < ' ') c |= '@';
+				if (x >= dispcols) { /* on to the next line */
+					x = 0;
+					y++;
+				}
+				if ((disp[relad + i] != c) && (y < displines)) {
+					disp[relad + i] = c;
+					touch(&dispdirty, y, x, x + 1);
+				}
+			}
 			return;
 		}
 	} else {
@@ -384,25 +466,18 @@ void dispwrite(WORD addr, WORD val) {
 	}
 }
 
-WORD dispread(WORD addr) {
+WORD dispread(struct hawk_machine * hm, WORD addr) {
 	/* addr is relative to display's address range */
+	if (batch) return batch_dispread(hm, addr);
 	if (addr >= (DISPBASE + DISPSTART)) {
 		if (addr >= dispend) { 
 			return 0xFFFFFFFF;
 		} else {
 			int relad = addr - (DISPBASE + DISPSTART);
-			int x = dispx + relad % dispcols;
-			int y = dispy + relad / dispcols;
-			unsigned char c0,c1,c2,c3;
-			move(y, x);
-			c0 = inch();
-			move(y, x+1);
-			c1 = inch();
-			move(y, x+2);
-			c2 = inch();
-			move(y, x+3);
-			c3 = inch();
-			return (c3 << 24) | (c2 << 16) | (c1 << 8) | c0;
+			return ((WORD)disp[relad + 3] << 24)
+			     | ((WORD)disp[relad + 2] << 16)
+			     | ((WORD)disp[relad + 1] << 8)
+			     |  (WORD)disp[relad];
 		}
 	} else if (addr == (DISPBASE + DISPLINES)) {
 		return (LINES - dispy) - 1;
@@ -429,11 +504,8 @@ static BYTE kbdstat = 0;   /* keyboard status bits follow */
 /* keyboard interrupt at level 7 in irq register */
 #define KBDIRQ   IRQ7
 
-static void kbdpoll() {
-	/* call whenever there is a need to poll the keyboard for input */
-	int ch;
-	ch = getch();
-	if (ch == ERR) return;
+static void kbdkey(struct hawk_machine * hm, int ch) {
+	/* the key ch was typed on the keyboard of hm */
 	kbdbuf = (BYTE)ch;
 	if ((kbdstat & KBDRDY) == 0) {
 		kbdstat |= KBDRDY;
@@ -442,13 +514,25 @@ static void kbdpoll() {
 		kbdstat |= KBDERR;
 	}
 	if ((kbdstat & KBDIE) != 0) {
-		irq |= KBDIRQ;
+		RAISE( KBDIRQ );
 	}
 }
 
-void kbdwrite(WORD addr, WORD val) {
+static void kbdpoll(struct hawk_machine * hm) {
+	/* call whenever there is a need to poll the keyboard for input */
+	int ch;
+	ch = getch();
+	if (ch == ERR) return;
+	kbdkey(hm, ch);
+}
+
+void kbdwrite(struct hawk_machine * hm, WORD addr, WORD val) {
 	/* addr is relative to keyboard's address range */
 	/* val is word to display */
+	if (batch) {
+		batch_kbdwrite(hm, addr, val);
+		return;
+	}
 	if (addr == (KBDBASE + KBDDATA)) {
 		/* no obvious function */
 	} else if (addr == (KBDBASE + KBDSTAT)) {
@@ -458,28 +542,41 @@ void kbdwrite(WORD addr, WORD val) {
 		/* only IE and ERR change, all else unchanged */
 	}
 	if ((kbdstat & KBDIE) == 0) { /* if interrupts disabled */
-		irq &= ~KBDIRQ; /* retract interrupt request */
+		RETRACT( KBDIRQ ); /* retract interrupt request */
 	}
 }
 
-WORD kbdread(WORD addr) {
+WORD kbdread(struct hawk_machine * hm, WORD addr) {
 	/* addr is relative to keyboard's address range */
+	if (batch) return batch_kbdread(hm, addr);
 	if (addr == (KBDBASE + KBDDATA)) {
 		kbdstat &= ~KBDRDY; /* turn off ready bit */
-		irq &= ~KBDIRQ; /* retract interrupt request */
+		RETRACT( KBDIRQ ); /* retract interrupt request */
 		return (WORD)kbdbuf;
 	} else if (addr == (KBDBASE + KBDSTAT)) {
 		WORD retval = (WORD)kbdstat;
 		if (!(retval & KBDRDY)) { /* if keyboard not ready */
-			usleep( 50000 );  /* be polite, 0.05 second delay */
+			doze( 50000000L ); /* be polite, 0.05 second delay */
 		}			  /* so polling loops relinquish cpu */
-		morecycles += cycles; /* be nice ...  */
-		cycles = 0;	      /* let output echo and keyboard poll */
+		hm->morecycles += hm->cycles; /* be nice ...  */
+		hm->cycles = 0;	      /* let output echo and keyboard poll */
 		return (WORD)retval;
 	}
 }
 
 
+WORD kbd_state() {
+	/* the keyboard's buffer and status, for snapshots */
+	return ((WORD)kbdstat << 8) | kbdbuf;
+}
+
+void kbd_setstate(WORD state) {
+	/* restore the keyboard from kbd_state() */
+	kbdbuf = (BYTE)state;
+	kbdstat = (BYTE)(state >> 8);
+}
+
+
 /********************
  * console function *
  ********************/
@@ -492,71 +589,294 @@ static void console_stop() {
 	exit(EXIT_SUCCESS);
 }
 
+static void console_tick(int sigraised) {
+	/* the interval timer, the display is due */
+	/* sigraised is ignored! */
+	framedue = TRUE;
+}
+
+static void console_pace() {
+	/* start the interval timer at framerate ticks per second */
+	struct itimerval it;
+	it.it_interval.tv_sec = 0;
+	it.it_interval.tv_usec = 1000000 / framerate;
+	it.it_value = it.it_interval;
+	setitimer(ITIMER_REAL, &it, NULL);
+}
+
+/* the machine the console shows and controls, for console_sig, which
+   is not handed it */
+static struct hawk_machine * shown = NULL;
+
 static void console_sig(int sigraised) {
 	/* control C or other events that stop run */
 	/* sigraised is ignored! */
 	signal(SIGINT, console_sig);
-	breakcycles = cycles;
-	cycles = 0;
+	breakcycles = shown->cycles;
+	shown->cycles = 0;
 	running = FALSE;
 	broken = TRUE;
 }
 
-void console_startup() {
+static void advance_frame(){
+	set_banner_colors();
+	nodelay(stdscr, TRUE);
+}
+
+static void recenter(struct hawk_machine * hm) {
+	/* keep the pc in the code shown by dump() */
+	if (dump_mode == CODEMODE) {
+		if (dump_addr > (hm->pc + 16)) {
+			dump_addr = hm->pc - 4;
+		} else if (dump_addr > hm->pc ) {
+			dump_addr = hm->pc;
+		} else if ((dump_addr + 16) <= hm->pc) {
+			dump_addr = hm->pc - 4;
+		}
+	}
+}
+
+/* changes asked for by change_display, counted by mode; they are made
+   by whoever next draws the machine */
+static int changes[2] = { 0, 0 };
+
+static void changed(int * c) {
+	/* make the changes counted in c */
+	for (; c[1] > 0; c[1]--) change_theme(0);
+	for (; c[0] > 0; c[0]--) {
+		dump_mode = (dump_mode == DATAMODE) ? CODEMODE : DATAMODE;
+	}
+}
+
+#ifdef RENDER
+/* with RENDER, see the Makefile, while the machine runs the front panel
+   is drawn by a thread of its own from a copy of the machine, shot, so
+   the CPU never waits on curses.  When a frame is due the CPU copies the
+   machine, unless the render thread is still drawing the last frame;
+   when the machine stops, the console takes the screen and draws the
+   machine itself.  screen guards curses and everything below */
+static pthread_mutex_t screen = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t copied = PTHREAD_COND_INITIALIZER;
+static pthread_t renderer;
+
+/* the bytes of memory, from dump_addr, that dump() may show */
+#define WINDOW 128
+
+static struct hawk_machine shot; /* the copy of the machine */
+static WORD shotmem[WINDOW >> 2]; /* the window of its memory */
+static BYTE * shotdisp;       /* its display */
+static struct dirty shotdirty; /* and the changes to it not yet drawn */
+static int shotready = FALSE; /* set when shot is copied but not drawn */
+static int typed = ERR;       /* a key read by the render thread */
+static int shotchanges[2] = { 0, 0 }; /* changes handed to it */
+
+static void frame(struct hawk_machine * hm) {
+	/* a frame is due, copy the machine for the render thread */
+	WORD a, base;
+	int y;
+	if (pthread_mutex_trylock(&screen) != 0) return; /* busy, later */
+	framedue = FALSE;
+	shotchanges[0] += changes[0];
+	shotchanges[1] += changes[1];
+	changes[0] = changes[1] = 0;
+	recenter(hm);
+	shot = *hm;
+	base = dump_addr & 0x00FFFFFCUL;
+	for (a = base; (a < (base + WINDOW)) && (a < hm->memsize); a += 4) {
+		shotmem[(a - base) >> 2] = hm->m[a >> 2];
+	}
+
+	/* dump() looks at shot.m[a >> 2] for a from base up, so offset
+	   shot.m to put base at shotmem[0], and end memory at the window */
+	shot.m = shotmem - (base >> 2);
+	if (a < hm->memsize) shot.memsize = a;
+
+	for (y = 0; y < displines; y++) { /* copy only the changes */
+		int lo = dispdirty.lo[y];
+		int hi = dispdirty.hi[y];
+		if (lo >= hi) continue;
+		memcpy(&shotdisp[(y * dispcols) + lo],
+		       &disp[(y * dispcols) + lo], hi - lo);
+		touch(&shotdirty, y, lo, hi);
+		dispdirty.lo[y] = dispcols;
+		dispdirty.hi[y] = 0;
+	}
+	if (typed != ERR) {
+		kbdkey(hm, typed);
+		typed = ERR;
+	}
+	shotready = TRUE;
+	pthread_cond_signal(&copied);
+	pthread_mutex_unlock(&screen);
+}
+
+static void * render(void * arg) {
+	/* the render thread, draw each copy of the machine */
+	/* arg is ignored! */
+	pthread_mutex_lock(&screen);
+	for (;;) {
+		int ch;
+		while (!shotready) pthread_cond_wait(&copied, &screen);
+		shotready = FALSE;
+		changed(shotchanges);
+		dump(&shot);
+		status(&shot);
+		showdisp(shotdisp, &shotdirty);
+		ch = getch();
+		if (ch != ERR) typed = ch;
+		refresh();
+	}
+	return NULL;
+}
+#else
+static void frame(struct hawk_machine * hm) {
+	/* a frame is due, draw the machine */
+	framedue = FALSE;
+	changed(changes);
+	recenter(hm);
+	dump(hm);
+	status(hm);
+	showdisp(disp, &dispdirty);
+	kbdpoll(hm);
+	refresh();
+}
+#endif
+
+void console_startup(struct hawk_machine * hm) {
 	/* startup, called from main */
 	/* initializes color themes*/
 	/* assume that breakpoint is already set or zeroed */
+	if (batch) {
+		batch_startup();
+		return;
+	}
+	shown = hm;
 	initscr(); cbreak(); noecho(); clear(); /* curses startup */
 	start_color();
 	init_themes_and_color_pairs();
 	signal(SIGINT, console_sig);
+	{ /* restart reads the tick interrupts, so getch() waits on */
+		struct sigaction sa;
+		sa.sa_handler = console_tick;
+		sigemptyset(&sa.sa_mask);
+		sa.sa_flags = SA_RESTART;
+		sigaction(SIGALRM, &sa, NULL);
+	}
+	console_pace();
 	title();
 	menu();
 
 	switch_colorful_nums();//for testing ripples, should be off normally
 
 	dispcols = COLS - dispx;
-	dispend = DISPBASE + (DISPSTART + (((LINES - dispy)-1) * (dispcols)));
+	displines = (LINES - dispy) - 1;
+	dispend = DISPBASE + (DISPSTART + (displines * dispcols));
+	disp = malloc(displines * dispcols + 4); /* + 4, a word past the end */
+	if (disp == NULL) {
+		endwin();
+		fputs(progname, stderr);
+		fputs(": out of memory for the display\n", stderr);
+		exit(EXIT_FAILURE); /* error */
+	}
+	memset(disp, ' ', displines * dispcols + 4);
+	makedirty(&dispdirty);
+#ifdef RENDER
+	shotdisp = malloc(displines * dispcols);
+	makedirty(&shotdirty);
+	if (shotdisp == NULL) {
+		endwin();
+		fputs(progname, stderr);
+		fputs(": out of memory for the render thread\n", stderr);
+		exit(EXIT_FAILURE); /* error */
+	}
+	{ /* the signal handlers run on the CPU's thread, not this one */
+		sigset_t mask, old;
+		sigemptyset(&mask);
+		sigaddset(&mask, SIGINT);
+		sigaddset(&mask, SIGALRM);
+		pthread_sigmask(SIG_BLOCK, &mask, &old);
+		if (pthread_create(&renderer, NULL, render, NULL)) {
+			endwin();
+			fputs(progname, stderr);
+			fputs(": cannot start the render thread\n", stderr);
+			exit(EXIT_FAILURE); /* error */
+		}
+		pthread_sigmask(SIG_SETMASK, &old, NULL);
+	}
+#endif
 }
 
-static void advance_frame(){
-	set_banner_colors();
-	nodelay(stdscr, TRUE);
+int console_running() {
+	/* nonzero unless the console has stopped the CPU */
+	if (batch) return TRUE;
+	return running;
 }
-void console() {
+
+static void panel(struct hawk_machine * hm);
+
+void console(struct hawk_machine * hm) {
 	/* console, called from main when countdown < 0 or halt */
-	if (dump_mode == CODEMODE) {
-		if (dump_addr > (pc + 16)) {
-			dump_addr = pc - 4;
-		} else if (dump_addr > pc ) {
-			dump_addr = pc;
-		} else if ((dump_addr + 16) <= pc) {
-			dump_addr = pc - 4;
+	if (batch) {
+		batch_console(hm);
+		return;
+	}
+	if (running && (hm->pc != hm->breakpoint) && (hm->pc != 0)) {
+		/* look again after recycle more cycles */
+		hm->cycles -= recycle;
+		hm->morecycles += recycle;
+		if (framedue) frame(hm);
+		return;
+	}
+#ifdef RENDER
+	pthread_mutex_lock(&screen); /* wait for the render thread */
+	shotready = FALSE;
+	changed(shotchanges);
+	{ /* draw what it did not from disp, which is the same or newer */
+		int y;
+		for (y = 0; y < displines; y++) {
+			if (shotdirty.lo[y] >= shotdirty.hi[y]) continue;
+			touch(&dispdirty, y, shotdirty.lo[y], shotdirty.hi[y]);
+			shotdirty.lo[y] = dispcols;
+			shotdirty.hi[y] = 0;
 		}
 	}
-	dump();
-	status();
-	if ((pc == breakpoint)||(pc == 0)) { /* address zero always a break */
+	panel(hm);
+	pthread_mutex_unlock(&screen);
+#else
+	panel(hm);
+#endif
+}
+
+static void panel(struct hawk_machine * hm) {
+	/* the machine is at a breakpoint or stopped, show it, and take
+	   commands until it runs again */
+	framedue = FALSE;
+	changed(changes);
+	recenter(hm);
+	dump(hm);
+	status(hm);
+	showdisp(disp, &dispdirty);
+	if ((hm->pc == hm->breakpoint)||(hm->pc == 0)) { /* address zero always a break */
 		if (animation_mode == 0){
 			running = FALSE;
+			if ((hm->pc == hm->breakpoint) && (snapname != NULL)) {
+				if (!snapshot_save( hm, snapname )) beep();
+			}
 		} else {
 			advance_frame();
-			struct timespec tim, tim2;
-			tim.tv_sec = 0;
-			tim.tv_nsec = 50000000L;
-			nanosleep(&tim, &tim2);
+			doze(50000000L);
 		}
 		which_menu = 1;
 	}
 	if (running) {
-		cycles -= recycle;
-		morecycles += recycle;
-		kbdpoll();
+		hm->cycles -= recycle;
+		hm->morecycles += recycle;
+		kbdpoll(hm);
 		refresh();
 		return;
 	}
 	if (broken) {
-		cycles = breakcycles;
+		hm->cycles = breakcycles;
 		which_menu = 1;
 		touchwin(stdscr);
 		refresh();
@@ -586,71 +906,72 @@ void console() {
 		case 'r': /* run command */
 			running = TRUE;
 			menu();
-			morecycles += (recycle + cycles);
-			cycles = -recycle; /* next refresh when it's positive */
+			hm->morecycles += (recycle + hm->cycles);
+			hm->cycles = -recycle; /* next refresh when it's positive */
 			advance_frame();
 			return;
 
 		case 's': /* single step command */
-			morecycles += cycles;
-			cycles = 0;
+			hm->morecycles += hm->cycles;
+			hm->cycles = 0;
 			advance_frame();
 			return;
 
 		case 'p': /* set breakpoint = number and run command */
-			breakpoint = number & 0xFFFFFFFEUL;
+			hm->breakpoint = number & 0xFFFFFFFEUL;
 			running = TRUE;
 			number = 0;
 			shownum();
 			menu();
 			refresh();
-			morecycles += (recycle + cycles);
-			cycles = -recycle;
+			hm->morecycles += (recycle + hm->cycles);
+			hm->cycles = -recycle;
 			advance_frame();
 			return;
 
 		case 'i': /* set breakpoint = pc and run command */
-			breakpoint = pc;
+			hm->breakpoint = hm->pc;
 			running = TRUE;
 			menu();
-			morecycles += (cycles+recycle);
-			cycles = -recycle;
+			hm->morecycles += (hm->cycles+recycle);
+			hm->cycles = -recycle;
 			advance_frame();
 			return;
 
 		case 'o': /* set breakpoint = lastjump and run command*/
-			breakpoint = r[1];
+			hm->breakpoint = hm->r[1];
 			running = TRUE;
 			menu();
-			morecycles += (cycles+recycle);
-			cycles = -recycle;
+			hm->morecycles += (hm->cycles+recycle);
+			hm->cycles = -recycle;
 			advance_frame();
 			return;
 
 		case 'n': /* set breakpoint = next instr and run command */
-			breakpoint = pc + sizeofop(pc);
+			hm->breakpoint = hm->pc + sizeofop(hm, hm->pc);
 			running = TRUE;
 			menu();
-			morecycles += (cycles+recycle);
-			cycles = -recycle;
+			hm->morecycles += (hm->cycles+recycle);
+			hm->cycles = -recycle;
 			advance_frame();
 			return;
 
 		case '>': /* move breakpoint */
-			breakpoint += 2;
-			dump();
+			hm->breakpoint += 2;
+			dump(hm);
 			refresh();
 			break;
 
 		case '<': /* move breakpoint */
-			breakpoint -= 2;
-			dump();
+			hm->breakpoint -= 2;
+			dump(hm);
 			refresh();
 			break;
 
-		case 'z': /* set execution speed */
-			if ((number > 0)&&(number <= 131072)) {
-				recycle = number;
+		case 'z': /* set display updates per second */
+			if ((number > 0)&&(number <= 1000)) {
+				framerate = number;
+				console_pace();
 				number = 0;
 				shownum();
 				refresh();
@@ -660,16 +981,22 @@ void console() {
 		case 'q': /* quit command */
 			console_stop();
 
+		case 'k': /* keep snapshot command */
+			if (!snapshot_save( hm, snapname ? snapname : SNAPNAME )) {
+				beep();
+			}
+			break;
+
 		case 'm': /* memory dump command */
 			dump_addr = number;
 			number = 0;
 			shownum();
-			dump();
+			dump(hm);
 			refresh();
 			break;
 
 		case 't': /* toggle memory dump mode command */
-			change_dump_mode();
+			change_dump_mode(hm);
 			break;
 
 		case '+': /* increment dumped memory command */
@@ -678,7 +1005,7 @@ void console() {
 			} else {
 				dump_addr += 0x0008UL;
 			}
-			dump();
+			dump(hm);
 			refresh();
 			break;
 
@@ -688,7 +1015,7 @@ void console() {
 			} else {
 				dump_addr -= 0x0008UL;
 			}
-			dump();
+			dump(hm);
 			refresh();
 			break;
 
@@ -714,23 +1041,22 @@ void console() {
 		
 		case 'x': /* turn on/off colorful numbers*/
 			switch_colorful_nums();
+			touchall(&dispdirty); /* recolor the display */
 			refresh();
-			console();
+			panel(hm);
 			break;
 
 		case 'w': /* run command */
 			if (animation_mode == 0) {
 				running = TRUE;
 				animation_mode = 1;
-				recycle=0x20000;
 				menu();
-				morecycles += (recycle + cycles);
-				cycles = -recycle; /* next refresh when it's positive */
+				hm->morecycles += (recycle + hm->cycles);
+				hm->cycles = -recycle; /* next refresh when it's positive */
 				advance_frame();
 			}
 			else {
 				animation_mode=0;
-				recycle=21;
 			}
 			return;
 		}
@@ -740,18 +1066,12 @@ void console() {
 }
 
 void change_display(int mode){
-	switch (mode)
-	{
-	case 1:
-		change_theme(0);
-		break;
-	case 0:
-		change_dump_mode();
-		break;
-	}
+	/* asked for by hawk, made when the machine is next drawn */
+	if (batch) return;
+	if ((mode == 0) || (mode == 1)) changes[mode]++;
 }
 
-static void change_dump_mode(){
+static void change_dump_mode(struct hawk_machine * hm){
 	if (dump_mode == DATAMODE)
 	{
 		dump_mode = CODEMODE;
@@ -760,6 +1080,6 @@ static void change_dump_mode(){
 	{
 		dump_mode = DATAMODE;
 	}
-	dump();
+	dump(hm);
 	refresh();
 }
\ No newline at end of file
@@ -10,33 +10,48 @@
  * memory mapped display *
  *************************/
 
-void dispwrite(WORD addr, WORD val);
+/* each device handler is given hm, the machine making the reference,
+   see machine.h */
+
+void dispwrite(struct hawk_machine * hm, WORD addr, WORD val);
 /* addr is relative to display's address range */
 /* val is value to display */
 
-WORD dispread(WORD addr);
+WORD dispread(struct hawk_machine * hm, WORD addr);
 /* addr is relative to display's address range */
 
 /**************************
  * memory mapped keyboard *
  **************************/
 
-void kbdwrite(WORD addr, WORD val);
+void kbdwrite(struct hawk_machine * hm, WORD addr, WORD val);
 /* addr is relative to keyboard's address range */
 /* val is word to display */
 
-WORD kbdread(WORD addr);
+WORD kbdread(struct hawk_machine * hm, WORD addr);
 /* addr is relative to keyboard's address range */
 
+WORD kbd_state();
+/* the keyboard's buffer and status, packed in one word for snapshots */
+
+void kbd_setstate(WORD state);
+/* restore the keyboard from kbd_state() */
+
 /********************
  * console function *
  ********************/
 
-void console_startup();
-/* startup, called from main */
+void console_startup(struct hawk_machine * hm);
+/* startup, called from main, for the machine hm that console() will
+   show and control, see machine.h */
+
+void console(struct hawk_machine * hm);
+/* console, called from main when countdown < 0 or halt; it shows and
+   controls the machine hm */
 
-void console();
-/* console, called from main when countdown < 0 or halt */
+int console_running();
+/* nonzero unless the console has stopped the CPU; in batch mode,
+   always nonzero, see smp.h */
 
 void change_display(int mode);
 /* change the display from within hawk */
\ No newline at end of file
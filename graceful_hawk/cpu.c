@@ -17,6 +17,23 @@
    Revised: Dec  16, 2019 - make LOAD, LOADS, LIL allow dst=PC
    Revised: Nov   8, 2023 - change stdint.h to inttypes.h
    Revised: Dec  11, 2023 - make interrupts work
+   Revised: Oct  16, 2026 - predecode instructions, see decode.c
+   Revised: Oct  16, 2026 - move instructions to ops.h, add threaded engine
+   Revised: Oct  16, 2026 - add block engine, see block.c
+   Revised: Oct  16, 2026 - compile hot blocks to host code, see jit.c
+   Revised: Oct  16, 2026 - compute condition codes lazily
+   Revised: Oct  16, 2026 - start from a restored snapshot, see snapshot.c
+   Revised: Oct  16, 2026 - memory size set at powerup
+   Revised: Oct  16, 2026 - add memory management unit, see mmu.c
+   Revised: Oct  16, 2026 - run more than one core, see smp.c
+   Revised: Oct  16, 2026 - machine state in struct hawk_machine, see machine.h
+   Revised: Oct  16, 2026 - cpu_reset and cpu_run for libhawk, see libhawk.h
+   Revised: Oct  16, 2026 - count instructions and cycles by address, see profile.h
+   Revised: Oct  16, 2026 - follow calls and returns for the call graph
+   Revised: Oct  16, 2026 - and for the timeline
+   Revised: Oct  16, 2026 - trace each instruction run, see itrace.h
+   Revised: Oct  16, 2026 - simulate L1 caches, see cache.h
+   Revised: Oct  16, 2026 - performance counters for CPUGET and CPUSET
 
    Language: C (UNIX)
    Purpose: Hawk instruction set emulator
@@ -26,10 +43,20 @@
 #define MAIN
 #include <inttypes.h>
 #include <stdbool.h>
+#include <stddef.h>
 #include "bus.h"
 #include "powerup.h"
 #include "console.h"
 #include "float.h"
+#include "decode.h"
+#include "block.h"
+#include "jit.h"
+#include "mmu.h"
+#include "smp.h"
+#include "machine.h"
+#include "profile.h"
+#include "itrace.h"
+#include "cache.h"
 
 /************************************************************/
 /* Declarations of machine components not included in bus.h */
@@ -37,21 +64,57 @@
 					
 					}*/
 
-static WORD irb; /* instruction register buffer */
-static HALF ir;  /* the instruction register */
-
-/* ir fields OP DST S1 S2 | OP DST OP1 SRC | OP DST OP1 X | OP DST CONST */
-#include "irfields.h"
-
-static WORD ea;     /* the effective address */
-
-static WORD snoop;  /* the snooping address (LOADL,STOREC) */
+/* instructions are predecoded, see decode.h; the fields of the current
+   instruction come from its decoded record, pointed to by di in main */
+#define DST   (di->dst)
+#define S1    (di->s1)
+#define OP1   S1
+#define S2    (di->s2)
+#define SRC   S2
+#define X     S2
+#define IMM   (di->imm)
+
+/* the state of the machine is in a struct hawk_machine, see machine.h,
+   pointed to by hm in every function that runs instructions; within
+   this file, most fields go by their own names, but memory and the
+   predecode cache are reached through MEMORY, see below, and irq, which
+   devices change, is always hm->irq */
+#define r           (hm->r)
+#define pc          (hm->pc)
+#define costat      (hm->costat)
+#define cocc        (hm->cocc)
+#define psw         (hm->psw)
+#define tpc         (hm->tpc)
+#define tma         (hm->tma)
+#define tsv         (hm->tsv)
+#define cycles      (hm->cycles)
+#define morecycles  (hm->morecycles)
+#define instructions (hm->instructions)
+#define breakpoint  (hm->breakpoint)
+#define cpuid       (hm->cpuid)
+#define vcode       (hm->vcode)
+#define vcodedelta  (hm->vcodedelta)
+#define vcodespan   (hm->vcodespan)
+#define lastpc      (hm->lastpc)
+
+#define ea          (hm->ea)      /* the effective address */
+#define snoop       (hm->snoop)   /* the snooping address (LOADL,STOREC) */
 
 /* the following are logically part of psw, but are computationally
    expensive, so not packed into PSW except when needed
 */
-static WORD carries; /* the carry bits from the adder */
-static WORD imask;   /* which interrupts are enabled (from LEVEL field) */
+#define carries     (hm->carries) /* the carry bits from the adder */
+#define imask       (hm->imask)   /* which interrupts are enabled */
+
+/* the condition codes and carries are computed lazily; the last
+   instruction to set them only records the operands and result of its
+   addition, and while cclazy is set, the N, Z, V, C and CBITS fields of
+   psw, and carries, are out of date until FLAGS computes them
+*/
+#define cclazy      (hm->cclazy)  /* nonzero if psw must be computed */
+#define ccx         (hm->ccx)     /* the adder's first operand */
+#define ccy         (hm->ccy)     /* the adder's second operand */
+#define ccr         (hm->ccr)     /* the result, ccx + ccy plus carry in */
 
 int animation_mode = 0;
 
@@ -59,44 +122,17 @@ int animation_mode = 0;
 /* Arithmetic Support */
 /**********************/
 
-/* sign extend byte to word */
-#define SXTB(x) {			\
-	if (x & 0x00000080UL)		\
-		x |= 0xFFFFFF00UL;	\
-	else				\
-		x &= 0x000000FFUL;	\
-}
-
-/* sign extend halfword to word */
-#define SXTH(x) {			\
-	if (x & 0x00008000UL)		\
-		x |= 0xFFFF0000UL;	\
-	else				\
-		x &= 0x0000FFFFUL;	\
-}
-
 /* add (a macro so you can redefine it if overflow is trapped) */
 #define ADDTO(x,y) x += y;
 
-/* add with carry setting condition codes */
-/* here, s is the sum discounting carries into each bit position,
-   the sign bit of tells if the signs of the operands differed, the
-   sign bit of o asks if signs of the operands are the same and the sign
-   of result is different, and the sign of c gives carry out of sign
-*/
+/* add with carry setting condition codes, see flags() */
 #define ADDTOCC(x,yy,cin) {		\
 	WORD y = yy;			\
-	WORD s = (x ^ y);		\
-	WORD c,v;			\
+	ccx = x;			\
+	ccy = y;			\
 	x += (y + (cin));		\
-	carries = s ^ x;		\
-	v = ~s & (x ^ y);		\
-	c = v ^ carries;		\
-	psw &= ~(CC | CBITS);		\
-	if (x & 0x80000000UL) psw |= N;	\
-	if (x == 0x00000000UL) psw |= Z;\
-	if (v & 0x80000000UL) psw |= V;	\
-	if (c & 0x80000000UL) psw |= C;	\
+	ccr = x;			\
+	cclazy = 1;			\
 }
 
 /* pack up the psw */
@@ -107,6 +143,7 @@ int animation_mode = 0;
 #define PACKPSW {			\
 	WORD srcbit = 0x00000010UL;	\
 	WORD dstbit = 0x00000100UL;	\
+	FLAGS;				\
 	while (srcbit) {		\
 		if (carries & srcbit) {	\
 			psw |= dstbit;	\
@@ -129,25 +166,61 @@ int animation_mode = 0;
 	imask = 0xFF >> (7 - PRIORITY); \
 }
 
-/* set condition codes for operations not involving the adder */
+/* set condition codes for operations not involving the adder, as
+   if x + 0, which sets no carries, V or C */
 #define SETCC(x) {			\
-	psw &= ~(CC | CBITS);		\
-	carries = 0;			\
-	if (x & 0x80000000UL) psw |= N;	\
-	if (x == 0x00000000UL) psw |= Z;\
-	/* V and C get reset */		\
+	ccx = x;			\
+	ccy = 0;			\
+	ccr = x;			\
+	cclazy = 1;			\
 }
 
+/* set more condition codes after ADDTOCC or SETCC; this is rare
+   enough that psw is brought up to date first */
+#define ORCC(f) { FLAGS; psw |= (f); }
+
 /* set C condition code for load operations that detect null bytes */
 #define SETNULLS(x) {			\
-	if (!(x & 0x000000FFUL)) { psw |= C; } \
-	if (!(x & 0x0000FF00UL)) { psw |= C; } \
-	if (!(x & 0x00FF0000UL)) { psw |= C; } \
-	if (!(x & 0xFF000000UL)) { psw |= C; } \
+	if (!(x & 0x000000FFUL)) { ORCC(C); } \
+	if (!(x & 0x0000FF00UL)) { ORCC(C); } \
+	if (!(x & 0x00FF0000UL)) { ORCC(C); } \
+	if (!(x & 0xFF000000UL)) { ORCC(C); } \
 }
 
-/* condition evaluation */
-#define COND(x) (cctab[psw & CC] & (1 << x))
+/* bring the condition codes in psw, and carries, up to date */
+/* here, s is the sum discounting carries into each bit position,
+   the sign bit of tells if the signs of the operands differed, the
+   sign bit of o asks if signs of the operands are the same and the sign
+   of result is different, and the sign of c gives carry out of sign
+*/
+static void flags( struct hawk_machine * hm ) {
+	WORD s = (ccx ^ ccy);
+	WORD c,v;
+	carries = s ^ ccr;
+	v = ~s & (ccr ^ ccy);
+	c = v ^ carries;
+	psw &= ~(CC | CBITS);
+	if (ccr & 0x80000000UL) psw |= N;
+	if (ccr == 0x00000000UL) psw |= Z;
+	if (v & 0x80000000UL) psw |= V;
+	if (c & 0x80000000UL) psw |= C;
+	cclazy = 0;
+}
+#define FLAGS { if (cclazy) flags( hm ); }
+
+/* condition evaluation; N Z V C are found as flags() would, but
+   without bringing psw up to date, since a branch seldom needs more */
+static WORD cccur( struct hawk_machine * hm ) {
+	WORD s, v;
+	if (!cclazy) return psw & CC;
+	s = ccx ^ ccy;
+	v = ~s & (ccr ^ ccy);
+	return ((ccr >> 28) & N)
+	     | ((ccr == 0x00000000UL) << 2)
+	     | ((v >> 30) & V)
+	     | ((v ^ s ^ ccr) >> 31);
+}
+#define COND(x) (cctab[cccur( hm )] & (1 << x))
 #define T   0x0001
 #define NS  0x0002
 #define ZS  0x0004
@@ -188,33 +261,55 @@ static unsigned int cctab[16] = {
 /* Input Output Bus */
 /********************/
 
-static WORD input( addr )
-WORD addr;
-{
+/* the devices serve one core at a time, see smp.h */
+#ifdef SMP
+#define DEVLOCK		smp_lock()
+#define DEVUNLOCK	smp_unlock()
+#else
+#define DEVLOCK
+#define DEVUNLOCK
+#endif
+
+static WORD input( struct hawk_machine * hm, WORD addr ) {
+	WORD value = 0xAAAAAAAA;
+	DEVLOCK;
 	if ((addr >= DISPBASE) && (addr <= DISPLIMIT)) {
-		return dispread( addr );
+		value = dispread( hm, addr );
 	} else if ((addr >= KBDBASE) && (addr <= KBDLIMIT)) {
-		return kbdread( addr );
+		value = kbdread( hm, addr );
 	}
-	return 0xAAAAAAAA;
+	DEVUNLOCK;
+	return value;
 }
 
-static void output( WORD addr, WORD value ) {
+static void output( struct hawk_machine * hm, WORD addr, WORD value ) {
+	DEVLOCK;
 	if ((addr >= DISPBASE) && (addr <= DISPLIMIT)) {
-		dispwrite( addr, value );
+		dispwrite( hm, addr, value );
 	} else if ((addr >= KBDBASE) && (addr <= KBDLIMIT)) {
-		kbdwrite( addr, value );
+		kbdwrite( hm, addr, value );
 	}
+	DEVUNLOCK;
 }
 
 /*******************************/
 /* Instruction Execution Cycle */
 /*******************************/
 
-WORD lastpc;	/* the value of PC used to fetch the current instruction */
+/* lastpc is the value of PC used to fetch the current instruction */
+
+/* count an event in the performance counter n, see bus.h */
+#define COUNT(n) (hm->counters[n]++)
 
 /* force a trap to vector - vector must be x_TRAP for some x */
 #define TRAP( vector ) {				\
+	COUNT( CNTTRAP );				\
+	TRAPTO( vector );				\
+}
+
+/* go to the trap or interrupt handler at vector */
+#define TRAPTO( vector ) {				\
+	FLAGS;						\
 	tpc = lastpc;					\
 	pc = vector;					\
 	psw &= ~OLEVEL;					\
@@ -223,855 +318,724 @@ WORD lastpc;	/* the value of PC used to fetch the current instruction */
 	UNPACKPSW;					\
 }
 
-/* after assign to PC, check for zero to allow zero as special breakpoint */
+/* after assign to PC, check for zero to allow zero as special breakpoint;
+   every branch taken and every jump comes here, so it is counted here */
 #define BRANCHCHECK {					\
+	COUNT( CNTBRANCH );				\
 	if (pc == 0) {					\
 		morecycles = morecycles + cycles;	\
 		cycles = 0;				\
 	}						\
 }
 
-/* fetch one word relative to PC, basis of instruction fetch */
-#define FETCHW {					\
-	if (pc >= MAXMEM) { /* fetch is illegal */	\
+/* memory and the predecode cache never move or change size once
+   powerup is done, so each engine starts with MEMORY, and each that
+   fetches from the predecode cache with DCACHE, making copies of
+   where they are and how big that the host compiler can keep in
+   registers; otherwise every store into m would force it to reload
+   them, since a store into m might change them for all it knows.
+   Code that only fetches, such as cpu_reset, needs only MEMTOP */
+#define MEMTOP const WORD memtop = hm->memsize
+#define MEMORY							\
+	MEMTOP;							\
+	WORD * const mem = hm->m;				\
+	const WORD romtop = hm->romsize
+#define DCACHE struct decoded * const dc = hm->dcache
+
+/* fetch one word relative to PC after a transfer of control; the
+   instruction itself comes from the predecode cache, so all that is
+   left of the fetch is the bounds check and the memory cycle.  If the
+   transfer turned the MMU on, pc is virtual and the paged engine will
+   check it, see MMUCHECK */
+#define PFETCHW {					\
+	if ((pc >= memtop) && !(psw & MMUON)) {		\
+		/* fetch is illegal */			\
 		tma = pc;				\
 		TRAP( BUS_TRAP );			\
 	}						\
 	/* fetch is legal */				\
-	irb = m[(WORD)(pc >> 2)];			\
 	cycles++;					\
 }
 
-/* fetch one halfword relative to PC, using FETCHW every other halfword */
-#define FETCH(r) { /* r = m[pc](halfword); pc += 2 */	\
-	if (pc & 0x2) { /* odd halfword */		\
-		r = irb >> 16;				\
-		pc += 2;				\
-		FETCHW; /* fetch next instr */		\
-	} else { /* even halfword */			\
-		r = irb & 0xFFFF;			\
-		pc += 2;				\
-	}						\
+/* fetch the predecoded instruction at pc and advance pc past its first
+   halfword; pc < memsize is guaranteed by FETCHW, and fetches counts the
+   words that FETCHW would have read while stepping through the whole
+   instruction.  pc advances by a constant, not by a field of the
+   decoded record, so consecutive fetches do not wait on each other */
+#define PFETCH {					\
+	COUNTFETCH( pc );				\
+	di = DECODEDIN( hm, dc, pc );			\
+	TRACEFETCH( pc, pc );				\
+	CACHEFETCH( pc );				\
+	cycles += di->fetches;				\
+	instructions++;					\
+	pc += 2;					\
+}
+
+#define FETCHW PFETCHW
+#define FETCH  PFETCH
+
+/* with PROFILE, each fetch of an instruction at a counts it and charges
+   the one before with the memory cycles used since it was fetched; with
+   no profile, this costs one compare per instruction */
+#ifdef PROFILE
+#define COUNTFETCH(a) {							\
+	struct profent * const prof = hm->prof;				\
+	if ((prof != NULL) && ((a) < memtop)) {				\
+		WORD now = cycles + morecycles;				\
+		hm->proflast->used += (WORD)(now - hm->profcycles);	\
+		hm->profcycles = now;					\
+		hm->proflast = &prof[(a) >> 1];				\
+		hm->proflast->count++;					\
+	}								\
+}
+#else
+#define COUNTFETCH(a)
+#endif
+
+/* with ITRACE, each fetch of an instruction at va, physical pa, puts it
+   in the trace, see itrace.h; with no trace, this costs one compare per
+   instruction */
+#ifdef ITRACE
+#define TRACEFETCH(va,pa) {						\
+	if (hm->itrace != NULL) itrace_fetch( hm, va, pa, di->len );	\
+}
+#else
+#define TRACEFETCH(va,pa)
+#endif
+
+/* with CACHE, each fetch of an instruction at physical address a, and
+   each load and store of memory at a, looks in the L1 caches, see
+   cache.h, adding the cost of any miss; with no caches, this costs one
+   compare per fetch, load and store */
+#ifdef CACHE
+#define CACHEFETCH(a) {							\
+	if ((hm->l1i != NULL) && ((a) < memtop)) {			\
+		cycles += l1_fetch( hm->l1i, a, di->len );		\
+	}								\
+}
+#define CACHED(a,write) {						\
+	if (hm->l1d != NULL) cycles += l1_access( hm->l1d, a, write );	\
+}
+#else
+#define CACHEFETCH(a)
+#define CACHED(a,write)
+#endif
+
+/* with PROFILE, calls and jumps that may be returns are followed on the
+   shadow call stack for the call graph, see profile.h; the profiler is
+   not part of libhawk */
+#if defined(PROFILE) && !defined(LIBHAWK)
+#define CALLED(link) { if (hm->calls != NULL) profile_call( hm, link ); }
+#define JUMPED       { if (hm->calls != NULL) profile_jump( hm ); }
+#else
+#define CALLED(link) {}
+#define JUMPED       {}
+#endif
+
+/* fetch the predecoded second halfword of a long instruction */
+#define FETCHIMM(r) {					\
+	r = IMM;					\
+	pc += 2;					\
 }
 
-#define LOAD(dst) { /* setup to load from memory */	\
-	if (ea >= MAXMEM) { /* load outside memory */	\
-		if (ea < IOSPACE) {			\
+/* how loads and stores account for themselves, the per instruction
+   engines count each memory cycle as it happens, abandon an instruction
+   that faults with NEXT and note stores that may hit predecoded code;
+   the block engine redefines these, see below */
+#define MEMCYCLE	cycles++
+#define BUSABORT	NEXT
+#define IOSTORED
+#define MEMSTORED(a)	DECODE_STORE( hm, a )
+
+/* load and store at physical address a for effective address ea;
+   without the MMU, a is ea, see LOAD and STORE */
+#define LOADAT(dst,a) { /* setup to load from memory */	\
+	if ((a) >= memtop) { /* load outside memory */	\
+		if ((a) < IOSPACE) {			\
 			tma = ea;			\
 			TRAP( BUS_TRAP );		\
 			FETCHW;				\
-			continue;			\
+			BUSABORT;			\
 		}					\
-		dst = input( ea );			\
+		dst = input( hm, a );			\
 	} else { /* load is normal */			\
-		dst = m[ea >> 2];			\
+		dst = mem[(a) >> 2];			\
+		CACHED( a, L1READ );			\
 	}						\
-	cycles++;					\
+	COUNT( CNTLOAD );				\
+	MEMCYCLE;					\
 }
 
-#define STORE(src) { /* setup to store to memory */	\
+#define STOREAT(src,a) { /* setup to store to memory */	\
 	if (ea == snoop) snoop |= 1;   \
-	if (ea >= MAXMEM) { /* store outside memory */	\
-		if (ea < IOSPACE) {			\
+	if ((a) >= memtop) { /* store outside memory */	\
+		if ((a) < IOSPACE) {			\
 			tma = ea;			\
 			TRAP( BUS_TRAP );		\
 			FETCHW;				\
-			continue;			\
+			BUSABORT;			\
 		}					\
-		output( ea, src );			\
-	} else if (ea < MAXROM) { /* store is illegal */\
+		output( hm, a, src );			\
+		COUNT( CNTSTORE );			\
+		IOSTORED;				\
+	} else if ((a) < romtop) { /* store is illegal */\
 		tma = ea;				\
 		TRAP( BUS_TRAP );			\
 		FETCHW;					\
-		continue;				\
+		BUSABORT;				\
 	} else { /* store is normal */			\
-		m[ea >> 2] = src;			\
+		mem[(a) >> 2] = src;			\
+		LINKSTORED( a );			\
+		COUNT( CNTSTORE );			\
+		CACHED( a, L1WRITE );			\
+		MEMSTORED( a );				\
 	}						\
-	cycles++;					\
+	MEMCYCLE;					\
 }
 
-int main(int argc, char ** argv) {
-	breakpoint = 0; /* powerup may override this default */
-	powerup(argc,argv);
-	console_startup();
+#define LOAD(dst)  LOADAT( dst, ea )
+#define STORE(src) STOREAT( src, ea )
+
+/* with more than one core, LOADL makes a reservation on the word it
+   loads and STOREC stores only if the reservation holds, see smp.h;
+   LINK comes after the LOAD of a LOADL, when PHYS( ea ) gives the
+   physical address it loaded from.  With one core, all a STOREC needs
+   is for snoop to be unchanged, which its caller checks */
+#ifdef SMP
+#define LINKSTORED(a)	SMP_STORED( a )
+#define LINK(val)	smp_link( hm, PHYS( ea ), val )
+#define STORECAT(src,a) {					\
+	if (((a) >= romtop) && ((a) < memtop)) { /* in RAM */	\
+		snoop |= 1;					\
+		COUNT( CNTSTORE );				\
+		if (smp_storec( hm, a, src )) {			\
+			CACHED( a, L1WRITE );			\
+			MEMSTORED( a );				\
+		} else { /* reservation lost */			\
+			psw |= V;				\
+		}						\
+		MEMCYCLE;					\
+	} else {						\
+		STOREAT( src, a );				\
+	}							\
+}
+#else
+#define LINKSTORED(a)
+#define LINK(val)
+#define STORECAT(src,a)	STOREAT( src, a )
+#endif
+
+#define PHYS(va)      (va)
+#define STORECOND(src) STORECAT( src, ea )
+
+/* these engines run with the MMU off; when an instruction turns it on,
+   return to main, which goes on with the paged engine, see below */
+#define MMUCHECK { if (psw & MMUON) return; }
+
+/* only core 0 has the console, see smp.h */
+#ifdef SMP
+#define CONSOLE {							\
+	if (cpuid == 0) {						\
+		smp_lock();						\
+		console( hm );						\
+		smp_unlock();						\
+	} else {							\
+		smp_console( hm );					\
+	}								\
+}
+#else
+#define CONSOLE console( hm )
+#endif
+
+/* between instructions, update the console when the display is due or
+   at a breakpoint, leaving the engine if it stopped the machine, then
+   check for interrupts; an interrupt starts over with the trap vector
+   as the next instruction */
+#define INTERLUDE {						\
+	if ( (!(cycles & 0x80000000UL))   /* positive -> display updt */ \
+	||   (pc == breakpoint)         ) /* we reach breakpoint */	\
+	/* then */ {							\
+		PACKPSW;						\
+		CONSOLE;						\
+		if (hm->stop) return;					\
+	}								\
+									\
+	lastpc = pc;							\
+									\
+	{								\
+		WORD intr = hm->irq & imask;				\
+		if (intr) { /* pending interrupt */			\
+			WORD vector = INTERRUPT_TRAP;			\
+			while ((intr & 1) == 0) { /* which interrupt */	\
+				intr = intr >> 1;			\
+				vector = vector + TRAP_VECTOR_STEP;	\
+			}						\
+			COUNT( CNTINTR );				\
+			TRAPTO( vector );				\
+			FETCHW;						\
+			continue;					\
+		}							\
+	}								\
+}
 
-	cycles = 0;
-	irq = 0;     /* no pending interrupts at startup */
-	psw = 0;     /* all PSW fields zero at startup */
-	imask = 0;   /* this is a consequence of PSW level field */
-	carries = 0; /* this is a consequence of PSW carries field */
-	FETCHW; /* fetch the first 2 instructions */
+/*********************/
+/* Execution Engines */
+/*********************/
+
+/* the switch interpreter, all instructions are dispatched by one jump */
+#define CASE(k) case 0x##k
+#define NEXT continue
+#define ILLEGAL goto illegal
+
+static void interpret( struct hawk_machine * hm ) {
+	MEMORY;
+	DCACHE;
+	struct decoded * di; /* the current instruction */
 	for (;;) {
-		if ( (!(cycles & 0x80000000UL))   /* positive -> display updt */
-		||   (pc == breakpoint)         ) /* we reach breakpoint */
-		/* then */ {
-			PACKPSW;
-			console();
-		}
+		INTERLUDE;
+		FETCH;
 
-		lastpc = pc;
+		r[0] = 0UL; /* force R0 to 0 before each instr */
 
-		{
-			WORD intr = irq & imask;
-			if (intr) { /* pending interrupt */
-				WORD vector = INTERRUPT_TRAP;
-				while ((intr & 1) == 0) { /* which interrupt */
-					intr = intr >> 1;
-					vector = vector + TRAP_VECTOR_STEP;
-				}
-				TRAP( vector );
-				FETCHW;
-				continue;
-			}
+		switch (di->op) { /* dispatch on the predecoded OP:OP1 */
+#include "ops.h"
 		}
+	illegal: /* only traps get here */
+		tma = 0;
+		TRAP( INSTRUCTION_TRAP );
+		FETCHW;
+	}
+}
 
-		FETCH(ir);
+#undef CASE
+#undef NEXT
+#undef ILLEGAL
+
+#ifdef __GNUC__
+/* the threaded interpreter, every instruction ends with its own copy of
+   the dispatch jump, so the host's branch predictor can learn which
+   instruction tends to follow which; needs gcc labels as values */
+#define CASE(k) op_##k
+#define NEXT {							\
+	if ( (!(cycles & 0x80000000UL))				\
+	||   (pc == breakpoint)					\
+	||   (hm->irq & imask)          ) continue;		\
+	lastpc = pc;						\
+	FETCH;							\
+	r[0] = 0UL;						\
+	goto *dispatch[di->op];					\
+}
+#define ILLEGAL goto illegal
+
+static void threaded( struct hawk_machine * hm ) {
+	static void * const dispatch[NUMOPS] = {
+		[0 ... NUMOPS - 1] = &&illegal,
+		[0xFF] = &&op_FF, [0xFE] = &&op_FE, [0xFD] = &&op_FD,
+		[0xFC] = &&op_FC, [0xFB] = &&op_FB, [0xFA] = &&op_FA,
+		[0xF9] = &&op_F9, [0xF8] = &&op_F8, [0xF7] = &&op_F7,
+		[0xF6] = &&op_F6, [0xF5] = &&op_F5, [0xF4] = &&op_F4,
+		[0xF3] = &&op_F3, [0xF2] = &&op_F2, [0xF1] = &&op_F1,
+		[0xF0] = &&op_F0, [0xE0] = &&op_E0, [0xD0] = &&op_D0,
+		[0xC0] = &&op_C0, [0xB0] = &&op_B0, [0xA0] = &&op_A0,
+		[0x90] = &&op_90, [0x80] = &&op_80, [0x70] = &&op_70,
+		[0x60] = &&op_60, [0x50] = &&op_50, [0x40] = &&op_40,
+		[0x30] = &&op_30, [0x20] = &&op_20, [0x1F] = &&op_1F,
+		[0x1E] = &&op_1E, [0x1D] = &&op_1D, [0x1C] = &&op_1C,
+		[0x1B] = &&op_1B, [0x1A] = &&op_1A, [0x19] = &&op_19,
+		[0x18] = &&op_18, [0x17] = &&op_17, [0x16] = &&op_16,
+		[0x15] = &&op_15, [0x14] = &&op_14, [0x13] = &&op_13,
+		[0x12] = &&op_12, [0x11] = &&op_11, [0x10] = &&op_10,
+		[0x00] = &&op_00, [OP_BUSFETCH] = &&op_100
+	};
+	MEMORY;
+	DCACHE;
+	struct decoded * di; /* the current instruction */
+	for (;;) {
+		INTERLUDE;
+		FETCH;
 
 		r[0] = 0UL; /* force R0 to 0 before each instr */
 
-		/***********************************
-		 * in all of the following cases,  *
-		 * normal exit is by continue,     *
-		 * meaning fetch the next instr,   *
-		 * while abnormal exit is by break *
-		 * leading to an instructio trap   *
-		 ***********************************/
-		switch (OP) { /* decode the instruction */
-
-		case 0xF: /* memory reference formats */
-
-			switch (OP1) { /* decode secondary opcode field */
-
-			case 0xF: /* MOVE */
-				if (DST == 0) break;
-				ea = 0;
-				r[0] = pc;
-				ADDTO(ea,r[X]);
-				r[DST] = ea;
-				continue;
-
-			case 0xE: /* MOVECC */
-				ea = 0;
-				r[0] = pc;
-				ADDTOCC(ea,r[X],0);
-				r[DST] = ea;
-				continue;
-
-			case 0xD: /* LOADS */
-				r[0] = pc;
-				ea = r[X] & 0xFFFFFFFCUL;
-				LOAD(r[DST]);
-				if (DST != 0) continue;
-				pc = r[0];
-				BRANCHCHECK;
-				FETCHW;
-				continue;
-
-			case 0xC: /* LOADSCC */
-				r[0] = pc;
-				ea = r[X] & 0xFFFFFFFCUL;
-				LOAD(r[DST]);
-				SETCC(r[DST]);
-				SETNULLS(r[DST]);
-				continue;
-
-			case 0xB: /* JSRS */
-				r[0] = pc;
-				ea = r[X];
-				r[DST] = pc;
-				pc = ea;
-				BRANCHCHECK;
-				FETCHW;
-				continue;
-
-			case 0xA: /* STORES */
-				if (X == 0) break;
-				r[0] = pc;
-				ea = r[X] & 0xFFFFFFFCUL;
-				r[0] = 0;
-				STORE(r[DST]);
-				continue;
-
-			case 0x9: /* -- LOADL, LOADSCC with added snooping */
-				if (X == 0) break;
-				r[0] = pc;
-				ea = r[X] & 0xFFFFFFFCUL;
-				snoop = ea;
-				LOAD(r[DST]);
-				SETCC(r[DST]);
-				SETNULLS(r[DST]);
-				continue;
-
-			case 0x8: /* -- STOREC, STORES with snoop-driven fail */
-				if (X == 0) break;
-				r[0] = pc;
-				ea = r[X] & 0xFFFFFFFCUL;
-				r[0] = 0;
-				psw &= ~(CC | CBITS);
-				if (ea == snoop) {
-					STORE(r[DST]);
-				} else {
-					psw |= V;
-				}
-				continue;
-
-			case 0x7: /* LEA */
-				#ifdef SPARROWHAWK
-					break;
-				#else
-					if (DST == 0) break;
-					FETCH(ea);
-					SXTH(ea);
-					r[0] = pc;
-					ADDTO(ea,r[X]);
-					r[DST] = ea;
-					continue;
-				#endif
-
-			case 0x6: /* LEACC */
-				#ifdef SPARROWHAWK
-					break;
-				#else
-					FETCH(ea);
-					SXTH(ea);
-					r[0] = pc;
-					ADDTOCC(ea,r[X],0);
-					r[DST] = ea;
-					continue;
-				#endif
-
-			case 0x5: /* LOAD */
-				#ifdef SPARROWHAWK
-					break;
-				#else
-					FETCH(ea);
-					SXTH(ea);
-					r[0] = pc;
-					ADDTO(ea,r[X]);
-					ea &= 0xFFFFFFFCUL;
-					LOAD(r[DST]);
-					if (DST != 0) continue;
-					pc = r[0];
-					BRANCHCHECK;
-					FETCHW;
-					continue;
-				#endif
-
-			case 0x4: /* LOADCC */
-				#ifdef SPARROWHAWK
-					break;
-				#else
-					FETCH(ea);
-					SXTH(ea);
-					r[0] = pc;
-					ADDTO(ea,r[X]);
-					ea &= 0xFFFFFFFCUL;
-					LOAD(r[DST]);
-					SETCC(r[DST]);
-					SETNULLS(r[DST]);
-					continue;
-				#endif
-
-			case 0x3: /* JSR */
-				#ifdef SPARROWHAWK
-					break;
-				#else
-					FETCH(ea);
-					SXTH(ea);
-					r[0] = pc;
-					ADDTO(ea,r[X]);
-					r[DST] = pc;
-					pc = ea;
-					BRANCHCHECK;
-					FETCHW;
-					continue;
-				#endif
-
-			case 0x2: /* STORE */
-				#ifdef SPARROWHAWK
-					break;
-				#else
-					FETCH(ea);
-					SXTH(ea);
-					r[0] = pc;
-					ADDTO(ea,r[X]);
-					ea &= 0xFFFFFFFCUL;
-					r[0] = 0;
-					STORE(r[DST]);
-					continue;
-				#endif
+		goto *dispatch[di->op];
+#include "ops.h"
 
-			case 0x1: /* -- */
-			case 0x0: /* -- */
-				break;
+	illegal: /* only traps get here */
+		tma = 0;
+		TRAP( INSTRUCTION_TRAP );
+		FETCHW;
+	}
+}
 
-			}
-			/* only traps get here */
-			break;
-
-		case 0xE: /* LIL */
-			#ifdef SPARROWHAWK
-				break;
-			#else
-				r[DST] = CONST;
-				FETCH(ea);
-				SXTH(ea);
-				r[DST] |= (ea << 8);
-				if (DST != 0) continue;
-				pc = r[0];
-				BRANCHCHECK;
-				FETCHW;
-				continue;
-			#endif
-
-		case 0xD: /* LIS */
-			if (DST == 0) break;
-			r[DST] = CONST;
-			SXTB(r[DST]);
-			continue;
+#undef CASE
+#undef NEXT
+#undef ILLEGAL
+#endif
 
-		case 0xC: /* ORIS */
-			if (DST == 0) break;
-			r[DST] <<= 8;
-			r[DST] |= CONST;
-			continue;
+/* run one instruction the ordinary way, for the block engine when it
+   cannot use a block */
+#define CASE(k) case 0x##k
+#define NEXT return
+#define ILLEGAL goto illegal
 
-		case 0xB: /* MOVESL */
-			if (S1 == 0) break;
-			{
-				int shift = (S2 - 1) & 0xF;
-				WORD d = r[S1];
-				WORD c = d & ~(0x7FFFFFFFUL >> shift);
-				WORD vm = 0x7FFFFFFFUL >> (shift + 1);
-				WORD v = d & ~vm;
-				r[DST] = d << (shift + 1);
-				SETCC(r[DST]);
-				if (c) psw |= C;
-				if (v) v = (v + vm + 1) & vm;
-				if (v) psw |= V;
-			}
-			continue;
+static void step( struct hawk_machine * hm ) {
+	MEMORY;
+	DCACHE;
+	struct decoded * di; /* the current instruction */
+	FETCH;
 
-		case 0xA: /* ADDSL */
-			if (DST == 0) break;
-			{
-				int shift = (S2 - 1) & 0xF;
-				WORD d = r[DST];
-				WORD c = d & ~(0x7FFFFFFFUL >> shift);
-				WORD vm = 0x7FFFFFFFUL >> (shift + 1);
-				WORD v = d & ~vm;
-				d <<= (shift + 1);
-				ADDTOCC(d,r[S1],0);
-				r[DST] = d;
-				if (c) psw |= C;
-				if (v) v = (v + vm + 1) & vm;
-				if (v) psw |= V;
-			}
-			continue;
+	r[0] = 0UL; /* force R0 to 0 before each instr */
 
-		case 0x9: /* ADDSR */
-			{
-				int shift = ((S2 - 1) & 0xF) + 1;
-				WORD d = r[DST];
-				WORD v;
-				WORD c;
-				WORD m = 0x7FFFFFFFUL >> (shift - 1);
-				ADDTOCC(d,r[S1],0);
-				v = d & ~(0xFFFFFFFFUL << shift);
-				c = d &  (0x00000001UL << (shift - 1));
-				d >>= shift;
-				if (psw & N) {
-					if (psw & V) {  /* neg and ovf */
-						d &= m; /*   make positive */
-					} else {        /* neg and no ovf */
-						d |= ~m;/*   make negative */
-					}
-				} else {
-					if (psw & V) {  /* pos and ovf */
-						d |= ~m;/*   make negative */
-					} else {        /* pos and no ovf */
-						d &= m; /*   make positive */
-					}
-				}
-				SETCC(d);
-				r[DST] = d;
-				if (v) psw |= V;
-				if (c) psw |= C;
-			}
-			continue;
+	switch (di->op) { /* dispatch on the predecoded OP:OP1 */
+#include "ops.h"
+	}
+illegal: /* only traps get here */
+	tma = 0;
+	TRAP( INSTRUCTION_TRAP );
+	FETCHW;
+}
 
-		case 0x8: /* ADDSRU */
-			{
-				int shift = ((S2 - 1) & 0xF) + 1;
-				WORD d = r[DST];
-				WORD v;
-				WORD c;
-				WORD m = 0x7FFFFFFFUL >> (shift - 1);
-				ADDTOCC(d,r[S1],0);
-				v = d & ~(0xFFFFFFFFUL << shift);
-				c = d &  (0x00000001UL << (shift - 1));
-				d >>= shift;
-				d &= m;
-				if (psw & C) {
-					d += (m + 1);
-				}
-				SETCC(d);
-				r[DST] = d;
-				if (v) psw |= V;
-				if (c) psw |= C;
-			}
-			continue;
+#undef CASE
+#undef NEXT
+#undef ILLEGAL
+
+/* the paged engine, the switch interpreter with every instruction
+   fetch, load and store translated through the MMU, see mmu.h.  A
+   translation that hits in vcode or vtlb costs one compare more than
+   the checks the other engines make; the rest go through mmu_miss */
+
+/* fetch the instruction at virtual address pc the slow way, when pc
+   is not in vcode or is in the last word of its page, so that the word
+   after it may be in some other frame; returns NULL after a trap */
+static struct decoded * fetchpaged( struct hawk_machine * hm ) {
+	WORD pa;   /* the physical address of the instruction */
+	WORD next; /* the physical address of the word after it */
+	struct decoded * d;
+
+	TRANSLATE( hm, pc, VEXEC, pa, return NULL );
+	if ((pa & WORDFIELD) < (WORDFIELD - 3)) {
+		vcode = pc & PAGEFIELD;
+		vcodedelta = pa - pc;
+		vcodespan = WORDFIELD - 3;
+		return DECODED( hm, pa );
+	}
+	if (pc & 2) { /* its second halfword is on the next page */
+		TRANSLATE( hm, pc + 2, VEXEC, next, return NULL );
+		return decode_split( hm, pa, next );
+	}
+	d = decode_split( hm, pa, pa + 2 );
+	if (d->fetches) { /* it prefetches the first word of the next page */
+		TRANSLATE( hm, pc + 4, VEXEC, next, return NULL );
+	}
+	return d;
+}
 
-		case 0x7: /* STUFFB */
-			if (DST == 0) break;
-			{
-				int d = DST;
-				int shift = ((int)(r[S2] & 3)) << 3;
-				WORD mask = ~(0x000000FFUL << shift);
-				r[d] = (r[d] & mask)
-				     | ((r[S1] & 0x000000FFUL) << shift);
-			}
-			continue;
+#undef FETCHW
+#undef FETCH
+#undef LOAD
+#undef STORE
+#undef PHYS
+#undef STORECOND
+#undef MMUCHECK
+
+/* FETCHW follows every trap and every transfer of control; a trap
+   always turns the MMU off, as may a return from trap, and either
+   leaves this engine */
+#define FETCHW { PFETCHW; MMUCHECK; }
+
+/* once FETCH has an instruction, the physical address of pc; fetchpaged
+   sets vcode for all but instructions split across two frames, and for
+   those, this is TRNONE, see itrace.h */
+#define FETCHPA (((WORD)(pc - vcode) < vcodespan) ? pc + vcodedelta : TRNONE)
+
+/* the unsigned compare fails both for pc outside vcode and for pc in
+   the last word of vcode, which may continue in another frame, so
+   those go to fetchpaged */
+#define FETCH {						\
+	COUNTFETCH( pc );				\
+	if ((WORD)(pc - vcode) < vcodespan) {		\
+		di = DECODEDIN( hm, dc, pc + vcodedelta );	\
+	} else {					\
+		di = fetchpaged( hm );		\
+		if (di == NULL) {			\
+			FETCHW;				\
+			NEXT;				\
+		}					\
+	}						\
+	TRACEFETCH( pc, FETCHPA );			\
+	CACHEFETCH( FETCHPA );				\
+	cycles += di->fetches;				\
+	instructions++;					\
+	pc += 2;					\
+}
 
-		case 0x6: /* STUFFH */
-			if (DST == 0) break;
-			{
-				int d = DST;
-				int shift = ((int)(r[S2] & 2)) << 3;
-				WORD mask = ~(0x0000FFFFUL << shift);
-				r[d] = (r[d] & mask)
-				     | ((r[S1] & 0x0000FFFFUL) << shift);
-			}
-			continue;
+#define LOAD(dst) {					\
+	WORD pa;					\
+	TRANSLATE( hm, ea, VREAD, pa, { FETCHW; BUSABORT; } );	\
+	LOADAT( dst, pa );				\
+}
 
-		case 0x5: /* EXTB */
-			if (S1 == 0) break;
-			{
-				int shift = ((int)(r[S2] & 3)) << 3;
-				WORD src = r[S1];
-				r[DST] = (src >> shift) & 0x000000FFUL;
-				SETCC(r[DST]);
-			}
-			continue;
+#define STORE(src) {					\
+	WORD pa;					\
+	TRANSLATE( hm, ea, VWRITE, pa, { FETCHW; BUSABORT; } );	\
+	STOREAT( src, pa );				\
+}
 
-		case 0x4: /* EXTH */
-			if (S1 == 0) break;
-			{
-				int shift = ((int)(r[S2] & 2)) << 3;
-				WORD src = r[S1];
-				r[DST] = (src >> shift) & 0x0000FFFFUL;
-				SETCC(r[DST]);
-			}
-			continue;
+#define PHYS(va) ((va) + hm->vtlb[VTLBINDEX( va )].delta)
 
-		case 0x3: /* ADD */
-			if (S1 == 0) break;
-			if (S2 == 0) break;
-			{
-				WORD dst = r[S1];
-				ADDTOCC(dst,r[S2],0);
-				r[DST] = dst;
-			}
-			continue;
+#define STORECOND(src) {				\
+	WORD pa;					\
+	TRANSLATE( hm, ea, VWRITE, pa, { FETCHW; BUSABORT; } );	\
+	STORECAT( src, pa );				\
+}
 
-		case 0x2: /* SUB */
-			if (S2 == 0) break;
-			{
-				WORD dst = r[S1];
-				ADDTOCC(dst,~r[S2],1);
-				r[DST] = dst;
-			}
-			continue;
+#define MMUCHECK { if (!(psw & MMUON)) return; }
 
-		case 0x1: /* Two register format */
-				
-			switch (OP1) { /* decode secondary opcode field */
-
-			case 0xF: /* TRUNC */
-				if (DST == 0) break;
-				{
-					int s = (SRC - 1) & 0xF;
-					WORD m = 0xFFFFFFFFUL << s;
-					WORD d = r[DST];
-					WORD g = d & m;
-					WORD c = d & (m<<1);
-					d &= ~(m<<1);
-					SETCC(d);
-					r[DST] = d;
-					if (c) psw |= C;
-					if (g) g = (~g) & m;
-					if (g) psw |= V;
-				}
-				continue;
-
-			case 0xE: /* SXT */
-				if (DST == 0) break;
-				{
-					int s = (SRC - 1) & 0xF;
-					WORD m = 0xFFFFFFFFUL << s;
-					WORD d = r[DST];
-					WORD g = d & m;
-					WORD c = d & (m<<1);
-					if (d&((~m)+1)) { /* negative */
-						d |= m;
-					} else { /* positive */
-						d &= ~m;
-					}
-					SETCC(d);
-					r[DST] = d;
-					if (c) psw |= C;
-					if (g) g = (~g) & m;
-					if (g) psw |= V;
-				}
-				continue;
-
-			case 0xD: /* BTRUNC */
-				if (DST == 0) break;
-				{
-					int s = ((SRC - 1) & 0xF) + 1;
-					WORD ms = 0xFFFFFFFFUL << s;
-					WORD d = r[DST] & ~ms;
-					ADDTO(pc, d << 1);
-					BRANCHCHECK;
-					FETCHW;
-				}
-				continue;
-
-			case 0xC: 
-				if (DST == 0){/* DISPLAY */
-					change_display(SRC);	
-				} else /* ADDSI */
-				{
-					WORD src = SRC;
-					if (src & 0x8) src |= 0xFFFFFFF0UL;
-					if (src == 0) src = 8;
-					ADDTOCC(r[DST], src, 0);
-				}
-				continue;
-
-			case 0xB: /* AND */
-				if (DST == 0) break;
-				if (SRC == 0) break;
-				r[DST] &= r[SRC];
-				SETCC(r[DST]);
-				continue;
-
-			case 0xA: /* OR  */
-				if (DST == 0) break;
-				if (SRC == 0) break;
-				r[DST] |= r[SRC];
-				SETCC(r[DST]);
-				continue;
-
-			case 0x9: /* EQU */
-				if (DST == 0) break;
-				r[DST] = ~(r[DST] ^ r[SRC]);
-				SETCC(r[DST]);
-				continue;
-
-			case 0x8: /* --  */
-				break;
-
-			case 0x7: /* ADDC */
-				{
-					int nz = (~psw) & Z;
-					ADDTOCC(r[DST], r[SRC], psw & C);
-					if (nz) psw &= ~Z;
-				}
-				continue;
+#define CASE(k) case 0x##k
+#define NEXT continue
+#define ILLEGAL goto illegal
 
-			case 0x6: /* SUBB */
-				{
-					int nz = (~psw) & Z;
-					ADDTOCC(r[DST], ~r[SRC], psw & C);
-					if (nz) psw &= ~Z;
-				}
-				continue;
-
-			case 0x5: /* ADJUST */
-				if (DST == 0) break;
-				{
-					WORD src = 0; /* effective source */
-					switch (SRC) { /* decode source */
-
-					case 0x0: /*  */
-					case 0x1: /*  */
-						break;
-
-					case 0x2: /* BCD */
-						src = (carries>>1)
-							& 0x08888888UL;
-						if (psw & C)
-							src |= 0x80000000UL;
-						src = (src >> 1)|(src >> 2);
-						src = (~src) + 1;
-						/* subtract 6 from digits
-						   that didn't produce carry */
-						break;
-
-					case 0x3: /* EX3 */
-						src = (carries>>1)
-							& 0x08888888UL;
-						if (psw & C)
-							src |= 0x80000000UL;
-						src |=   src >> 2      ;
-						src |= ((src << 1) | 1);
-						src ^= 0xCCCCCCCCUL;
-						/* either add or subtract 3
-						   to make correct excess-3 */
-						break;
-
-					case 0x4: /* CMSB */
-						if (psw & C)
-							src = 0x80000000UL;
-						break;
-
-					case 0x5: /* SSQ */
-						if ((psw & N) && (psw & V))
-							src = 0x00000001UL;
-						break;
-
-					case 0x6: /*  */
-					case 0x7: /*  */
-						break;
-
-					case 0x8: /* PLUS1 */
-						src = 1;
-						break;
-
-					case 0x9: /* PLUS2 */
-						src = 2;
-						break;
-
-					case 0xA: /* PLUS4 */
-						src = 4;
-						break;
-
-					case 0xB: /* PLUS8 */
-						src = 8;
-						break;
-
-					case 0xC: /* PLUS16 */
-						src = 16;
-						break;
-
-					case 0xD: /* PLUS32 */
-						src = 32;
-						break;
-
-					case 0xE: /* PLUS64 */
-						src = 64;
-						break;
-
-					case 0xF: /* PLUS128 */
-						src = 128;
-						break;
-					}
-					if (DST != 0) {
-						ADDTO(r[DST],src);
-					}
-				}
-				continue;
-
-			case 0x4: /* PLUS */
-				if (DST == 0) break;
-				r[0] = pc;
-				WORD dst = r[S1];
-				ADDTO(r[DST],r[S2]);
-				continue;
-
-			case 0x3: /* COGET */
-			    #ifdef SPARROWHAWK
-				break;
-			    #else
-				psw &= ~(CC | CBITS); /* always reset cc */
-				if (SRC == 0) {
-					if (costat == 0) psw |= Z;
-					r[DST] = costat;
-					continue;
-				} else switch (COSEL) {
-				case 0x0:
-					break; /* missing coprocessor */
-				case 0x1:
-					if (!(costat & COFPENAB)) {
-						TRAP( CO_TRAP );
-						FETCHW;
-						continue;
-					}
-					r[DST] = float_coget( SRC );
-					psw |= cocc; /* cond codes from cop */
-					continue;
-				case 0x2:
-				case 0x3:
-				case 0x4:
-				case 0x5:
-				case 0x6:
-				case 0x7:
-					break; /* missing coprocessor */
-				}
-				TRAP( CO_TRAP );
-				FETCHW;
-				continue;
-			    #endif
-
-			case 0x2: /* COSET */
-			    #ifdef SPARROWHAWK
-				break;
-			    #else
-				if (SRC == 0) {
-					costat = r[DST] & COMASK;
-					continue;
-				} else switch (COSEL) {
-				case 0x0:
-					break; /* missing coprocessor */
-				case 0x1:
-					if (!(costat & COFPENAB)) {
-						TRAP( CO_TRAP );
-						FETCHW;
-						continue;
-					}
-					float_coset( SRC, r[DST] );
-					continue;
-				case 0x2:
-				case 0x3:
-				case 0x4:
-				case 0x5:
-				case 0x6:
-				case 0x7:
-					break; /* missing coprocessor */
-				}
-				TRAP( CO_TRAP );
-				FETCHW;
-				continue;
-			    #endif
-
-			case 0x1: /* CPUGET */
-				if ((psw & LEVEL) == LEVEL) { /* all ones */
-					TRAP( PRIV_TRAP );
-					FETCHW;
-					continue;
-				}
-				{
-					WORD dst;
-					switch (SRC) { /* decode source */
-
-					case 0x0: /* PSW */
-						PACKPSW;
-						dst = psw;
-						break;
-
-					case 0x1: /* TPC */
-						dst = tpc;
-						break;
-
-					case 0x2: /* TMA */
-						dst = tma;
-						break;
-
-					case 0x3: /* TSV */
-						dst = tsv;
-						break;
-
-					case 0x4: /* -- */
-					case 0x5: /* -- */
-					case 0x6: /* -- */
-					case 0x7: /* -- */
-						break;
-
-					case 0x8: /* CYC */
-						dst = cycles + morecycles;
-						break;
-
-					case 0x9: /* -- */
-					case 0xA: /* -- */
-					case 0xB: /* -- */
-					case 0xC: /* -- */
-					case 0xD: /* -- */
-					case 0xE: /* -- */
-					case 0xF: /* -- */
-						break;
-					}
-					if (DST != 0) {
-						r[DST] = dst;
-					} else {
-						pc = dst;
-						psw &= ~LEVEL;
-						psw |= ((psw & OLEVEL) << 4);
-						psw &= ~OLEVEL;
-						BRANCHCHECK;
-						FETCHW;
-					}
-				}
-				continue;
-				/* control never reaches here */
+static void paged( struct hawk_machine * hm ) {
+	MEMORY;
+	DCACHE;
+	struct decoded * di; /* the current instruction */
+	for (;;) {
+		INTERLUDE;
+		FETCH;
 
-			case 0x0: /* CPUSET */
-				if ((psw & LEVEL) == LEVEL) { /* all ones */
-					TRAP( PRIV_TRAP );
-					FETCHW;
+		r[0] = 0UL; /* force R0 to 0 before each instr */
+
+		switch (di->op) { /* dispatch on the predecoded OP:OP1 */
+#include "ops.h"
+		}
+	illegal: /* only traps get here */
+		tma = 0;
+		TRAP( INSTRUCTION_TRAP );
+		FETCHW;
+	}
+}
+
+#undef CASE
+#undef NEXT
+#undef ILLEGAL
+
+/* back to the physical engines */
+#undef FETCHW
+#undef FETCH
+#undef FETCHPA
+#undef LOAD
+#undef STORE
+#undef PHYS
+#undef STORECOND
+#undef MMUCHECK
+#define FETCHW PFETCHW
+#define FETCH  PFETCH
+#define LOAD(dst)  LOADAT( dst, ea )
+#define STORE(src) STOREAT( src, ea )
+#define PHYS(va)   (va)
+#define STORECOND(src) STORECAT( src, ea )
+#define MMUCHECK { if (psw & MMUON) return; }
+
+/* the block engine, whole basic blocks run between the checks for
+   display updates, breakpoints and interrupts, with the memory cycles
+   of each block charged once when it is done, see block.h.  An
+   instruction in a block that traps or that stores into I/O space
+   or predecoded code ends the block early, charging only for the
+   part of the block that was used, so interrupts and cycle counts
+   come out just as they would for the other engines */
+#define CASE(k) case 0x##k
+#define NEXT { u++; continue; }
+#define ILLEGAL goto illegal
+
+#undef MEMCYCLE
+#undef BUSABORT
+#undef IOSTORED
+#undef MEMSTORED
+#define MEMCYCLE	/* counted in advance by block.c */
+#define BUSABORT	{ LEFT( 0 ); goto leave; }
+#define IOSTORED	{ LEFT( 1 ); goto leave; }
+#define MEMSTORED(a)	{						\
+	if (hm->dpage[(a) >> DPAGEBITS]) { /* block may be stale */	\
+		decode_flush( hm, a );					\
+		LEFT( 1 );						\
+		goto leave;						\
+	}								\
+}
+
+/* charge for the part of the block used when leaving it early,
+   through the current instruction, with n data memory cycles */
+#define LEFT(n) {							\
+	cycles += u->cyc + di->fetches + (n);				\
+	instructions += (u - b->u) + 1;					\
+}
+
+static void blocks( struct hawk_machine * hm ) {
+	MEMORY;
+	struct block * b;    /* the current block */
+	struct uop * u;      /* the current micro-op in b */
+	struct decoded * di; /* the current instruction, in u */
+	#ifdef JIT
+		int jitting = (engine == ENGINE_JIT)
+			   && jit_init( hm, cctab );
+	#endif
+	while (!(psw & MMUON)) { /* step() may turn it on */
+		INTERLUDE;
+		b = BLOCK( hm, pc );
+		u = b->u;
+		if ( (u->d.op == OP_STEP)
+		||   ((WORD)(breakpoint - pc - 1) < (WORD)(b->end - pc - 1)) )
+		/* then */ { /* not blockable, or breakpoint within block */
+			step( hm );
+			continue;
+		}
+		#ifdef JIT
+			if (jitting) {
+				if (b->native) { /* run host code */
+					FLAGS; /* host code keeps psw current */
+					if (jit_run( hm, b )) step( hm );
 					continue;
 				}
-				switch (SRC) { /* decode terenary opcode */
+				if ((b->count < JIT_HOT)
+				&&  (++b->count == JIT_HOT)) jit_compile( hm, b );
+			}
+		#endif
 
-				case 0x0: /* PSWSET */
-					psw = r[DST];
-					UNPACKPSW;
-					continue;
+		while (di = &u->d, di->op != OP_END) {
+			lastpc = pc;
+			pc += 2;
 
-				case 0x1: /* TPCSET */
-					tpc = r[DST];
-					continue;
+			r[0] = 0UL; /* force R0 to 0 before each instr */
 
-				case 0x2: /* TMASET */
-					tma = r[DST];
-					continue;
+			switch (di->op) { /* dispatch on the predecoded OP:OP1 */
+#include "ops.h"
+			}
+		illegal: /* only traps get here */
+			LEFT( 0 );
+			tma = 0;
+			TRAP( INSTRUCTION_TRAP );
+			FETCHW;
+			goto leave;
+		}
+		cycles += IMM; /* the whole block is done */
+		instructions += u - b->u;
+	leave:	;
+	}
+}
 
-				case 0x3: /* TSVSET */
-					tsv = r[DST];
-					continue;
+#undef CASE
+#undef NEXT
+#undef ILLEGAL
 
-				case 0x4: /* -- */
-				case 0x5: /* -- */
-				case 0x6: /* -- */
-				case 0x7: /* -- */
-					continue;
+void cpu_reset( struct hawk_machine * hm ) {
+	/* power up the core hm */
+	MEMTOP;
+	int i;
+	cclazy = 0;  /* psw holds the condition codes */
+	cycles = 0;
+	hm->irq = 0; /* no pending interrupts at startup */
+	psw = 0;     /* all PSW fields zero at startup */
+	imask = 0;   /* this is a consequence of PSW level field */
+	carries = 0; /* this is a consequence of PSW carries field */
+	for (i = 0; i < 16; i++) hm->counters[i] = 0;
+	hm->counters[CNTINSTR] = instructions; /* counts from here */
+	FETCHW; /* fetch the first 2 instructions */
+}
 
-				case 0x8: /* CYCSET */
-					morecycles = r[DST];
-					cycles = 0;
-					continue;
+static void run( struct hawk_machine * hm ) {
+	/* run the core hm until the console stops it, which the hawk
+	   program's console never does */
+	while (!hm->stop) { /* each engine also returns when the MMU is
+			       turned on or off */
+		if (psw & MMUON) {
+			paged( hm );
+		#ifdef __GNUC__
+		} else if (engine == ENGINE_THREADED) {
+			threaded( hm );
+		#endif
+		} else if (engine >= ENGINE_BLOCK) {
+			blocks( hm );
+		} else {
+			interpret( hm );
+		}
+	}
+}
 
-				case 0x9: /* -- */
-				case 0xA: /* -- */
-				case 0xB: /* -- */
-				case 0xC: /* -- */
-				case 0xD: /* -- */
-				case 0xE: /* -- */
-				case 0xF: /* -- */
-					continue;
+static void resume( struct hawk_machine * hm ) {
+	/* pick up where hm left off, with psw packed, as it is whenever
+	   console() is called */
+	cclazy = 0;  /* psw holds the condition codes */
+	carries = 0;
+	UNPACKPSW;
+}
 
-				}
-				/* control never reaches here */
-			}
-			/* only traps get here */
-			break;
-
-		case 0x0: /* Bcc */
-			/* CONST == 0xFF could be illegal, infinite loop */
-			/* CONST == 0xFF could be sleep command */
-			if (DST == 0x8) break;
-			if (COND(DST)) {
-				ea = CONST;
-				SXTB(ea);
-				ADDTO(pc, ea << 1);
-				BRANCHCHECK;
-				FETCHW;
-			}
-			continue;
+void cpu_run( struct hawk_machine * hm ) {
+	/* run hm until console() sets hm->stop */
+	resume( hm );
+	if ((pc >= hm->memsize) && !(psw & MMUON)) { /* pc was set badly */
+		lastpc = pc;
+		tma = pc;
+		TRAP( BUS_TRAP );
+	}
+	run( hm );
+}
+
+#if defined(SMP) && !defined(LIBHAWK)
+static void core( struct hawk_machine * hm ) {
+	/* each core after the first, see smp.h; started by main */
+	cpu_reset( hm );
+	run( hm );
+}
+#endif
+
+/* a program built on libhawk.a, see libhawk.h, has its own main; cpu.c
+   is compiled for it with LIBHAWK defined */
+#ifndef LIBHAWK
+
+/* core 0, the machine on the console */
+static struct hawk_machine core0;
+
+int main(int argc, char ** argv) {
+	struct hawk_machine * const hm = &core0;
+	mmu_flush( hm ); /* the MMU starts with no translations */
+	breakpoint = 0; /* powerup may override this default */
+	#if defined(THREADED)
+		engine = ENGINE_THREADED;
+	#elif defined(BLOCKS)
+		engine = ENGINE_BLOCK;
+	#elif defined(JIT)
+		engine = ENGINE_JIT;
+	#else
+		engine = ENGINE_SWITCH;
+	#endif
+	powerup(hm,argc,argv);
+	decode_init( hm );
+	#ifdef PROFILE
+		if ((profname != NULL) || (foldname != NULL)
+		||  (timename != NULL)) {
+			profile_start( hm, profname, foldname, timename,
+				       listname );
 		}
-		/* only traps get here */
-		tma = 0;
-		TRAP( INSTRUCTION_TRAP );
-		FETCHW;
+	#endif
+	#ifdef ITRACE
+		if (itracename != NULL) itrace_start( hm, itracename );
+	#endif
+	#ifdef CACHE
+		if ((l1iname != NULL) || (l1dname != NULL)) {
+			l1_start( hm, l1iname, l1dname );
+		}
+	#endif
+	console_startup( hm );
+
+	if (restored) { /* powerup restored a snapshot, see snapshot.h */
+		resume( hm ); /* psw was packed when the snapshot was taken */
+	} else {
+		cpu_reset( hm );
 	}
+	block_flushall( hm );
+	#ifdef SMP
+		smp_start( hm, core );
+	#endif
+	run( hm );
 }
+
+#endif
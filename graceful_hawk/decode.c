@@ -0,0 +1,218 @@
+/* File: decode.c
+   Date: Oct. 16, 2026
+   Language: C (UNIX)
+   Purpose: Hawk Emulator, instruction predecode cache;
+		instructions are decoded once per halfword address and
+		the decoded records are reused until memory is modified.
+*/
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include "bus.h"
+#include "decode.h"
+#include "block.h"
+#include "mmu.h"
+#include "machine.h"
+
+/* ir fields OP DST S1 S2 | OP DST OP1 SRC | OP DST OP1 X | OP DST CONST,
+   where ir is the instruction being decoded, passed to each function
+   that needs it, since other machines may be decoding at the same time */
+#include "irfields.h"
+
+/*************************
+ * the predecode cache   *
+ *************************/
+
+/* get halfword m[a] */
+#define HALFWORD(m,a) ((HALF)(((a) & 2) ? ((m)[(a) >> 2] >> 16) : (m)[(a) >> 2]))
+
+/* sign extend byte and halfword to word */
+#define SXTB(x) ((WORD)(SWORD)(int8_t)(x))
+#define SXTH(x) ((WORD)(SWORD)(int16_t)(x))
+
+static int islong( HALF ir ) {
+	/* does the instruction in ir take a second halfword? */
+	#ifdef SPARROWHAWK
+		return 0;
+	#else
+		if (OP == 0xE) return 1; /* LIL */
+		if (OP != 0xF) return 0;
+		if (OP1 == 0x7) return DST != 0; /* LEA R0 traps before fetch */
+		return (OP1 >= 0x2) && (OP1 <= 0x7);
+	#endif
+}
+
+static void * reserve( size_t size ) {
+	/* zeroed storage for size bytes, given pages only when touched */
+	void * p = mmap( NULL, size, PROT_READ | PROT_WRITE,
+			 MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0 );
+	if (p == MAP_FAILED) {
+		fputs( progname, stderr );
+		fputs( ": cannot allocate the predecode cache\n", stderr );
+		exit( EXIT_FAILURE ); /* error */
+	}
+	return p;
+}
+
+static HALF decode( struct decoded * d, WORD * m, WORD a ) {
+	/* decode all but the immediate of the instruction in m[a] into d,
+	   returning the instruction */
+	HALF ir = HALFWORD( m, a );
+	d->dst = DST;
+	d->s1 = S1;
+	d->s2 = S2;
+	d->imm = 0;
+	if ((OP == 0xF) || (OP == 0x1)) {
+		d->op = (OP << 4) | OP1;
+	} else {
+		d->op = OP << 4;
+	}
+	d->len = islong( ir ) ? 4 : 2;
+
+	/* a long instruction always crosses one word boundary, a short
+	   one crosses only if it is in the odd halfword of its word */
+	d->fetches = ((d->len == 4) || (a & 2)) ? 1 : 0;
+	return ir;
+}
+
+static void immediate( struct decoded * d, HALF ir, WORD * m, WORD a2 ) {
+	/* finish decoding the instruction ir into d, where m[a2] holds
+	   its second halfword, if it has one */
+	switch (OP) {
+
+	case 0xF: /* memory reference formats */
+		if (d->len == 4) d->imm = SXTH( HALFWORD( m, a2 ) );
+		break;
+
+	case 0xE: /* LIL */
+		if (d->len == 4) d->imm = CONST | (SXTH( HALFWORD( m, a2 ) ) << 8);
+		break;
+
+	case 0xD: /* LIS */
+		d->imm = SXTB( CONST );
+		break;
+
+	case 0xC: /* ORIS */
+		d->imm = CONST;
+		break;
+
+	case 0x1: /* ADDSI */
+		if (OP1 == 0xC) {
+			WORD src = SRC;
+			if (src & 0x8) src |= 0xFFFFFFF0UL;
+			if (src == 0) src = 8;
+			d->imm = src;
+		}
+		break;
+
+	case 0x0: /* Bcc, byte displacement */
+		d->imm = SXTB( CONST ) << 1;
+		break;
+	}
+}
+
+/* mark the decode page holding m[a] of machine h as holding decoded
+   instructions, and forget the length of decoded record d; other cores
+   read both as they run, see smp.h */
+#ifdef SMP
+#define MARKPAGE(h,a) __atomic_store_n( &(h)->dpage[(a) >> DPAGEBITS], 1, \
+					__ATOMIC_SEQ_CST )
+#define CLEARLEN(d)   __atomic_store_n( &(d)->len, 0, __ATOMIC_RELAXED )
+#else
+#define MARKPAGE(h,a) ((h)->dpage[(a) >> DPAGEBITS] = 1)
+#define CLEARLEN(d)   ((d)->len = 0)
+#endif
+
+/*************
+ * Interface *
+ *************/
+
+void decode_init( struct hawk_machine * hm ) {
+	/* allocate the cache, once memsize is known */
+	hm->dcache = reserve( sizeof(struct decoded)
+			      * (size_t)(hm->memsize >> 1) );
+	hm->dpage = reserve( hm->memsize >> DPAGEBITS );
+}
+
+void decode_free( struct hawk_machine * hm ) {
+	/* give back the cache allocated by decode_init */
+	munmap( hm->dcache, sizeof(struct decoded)
+			    * (size_t)(hm->memsize >> 1) );
+	munmap( hm->dpage, hm->memsize >> DPAGEBITS );
+	hm->dcache = NULL;
+	hm->dpage = NULL;
+}
+
+struct decoded * decode_fill( struct hawk_machine * hm, WORD a ) {
+	/* decode the instruction in m[a], a < memsize, into dcache */
+	struct decoded * d = &hm->dcache[a >> 1];
+	struct decoded t;
+	WORD next;  /* address of instruction word prefetched after this */
+	HALF ir;
+	BYTE len;
+
+	/* a store into the page must not miss the flush, so the page is
+	   marked before the instruction is read from it; with other cores,
+	   see smp.h, a store they make after the mark flushes d, and one
+	   made before it is seen by the reads below.  A long instruction
+	   may have its second halfword in the next page, marked too */
+	MARKPAGE( hm, a );
+	ir = decode( &t, hm->m, a );
+	if ((t.len == 4) && ((a + 2) < hm->memsize)) MARKPAGE( hm, a + 2 );
+	next = (a + t.len) & (WORD)0xFFFFFFFCUL;
+	if (t.fetches && (next >= hm->memsize)) {
+		t.op = OP_BUSFETCH;
+		t.imm = next;
+	} else {
+		immediate( &t, ir, hm->m, a + 2 );
+	}
+
+	/* other cores may be fetching from d; they must not see its
+	   length until the rest of it is there */
+	len = t.len;
+	t.len = 0;
+	*d = t;
+	#ifdef SMP
+		__atomic_store_n( &d->len, len, __ATOMIC_RELEASE );
+	#else
+		d->len = len;
+	#endif
+	return d;
+}
+
+struct decoded * decode_split( struct hawk_machine * hm, WORD a, WORD a2 ) {
+	/* decode the instruction in m[a] and m[a2] into a scratch record */
+	struct decoded * d = &hm->split;
+	immediate( d, decode( d, hm->m, a ), hm->m, a2 );
+	return d;
+}
+
+void decode_flush( struct hawk_machine * hm, WORD a ) {
+	/* invalidate the decode page holding m[a] */
+	WORD page = a >> DPAGEBITS;
+	struct decoded * d = &hm->dcache[(page << DPAGEBITS) >> 1];
+	int i;
+
+	/* only the lengths are cleared, so that another core in the midst
+	   of fetching one of these still sees all of it */
+	for (i = 0; i < (1 << (DPAGEBITS - 1)); i++) CLEARLEN( &d[i] );
+	hm->dpage[page] = 0;
+
+	/* a long instruction in the last halfword of the previous page
+	   extends into this one */
+	if (page > 0) CLEARLEN( &hm->dcache[((page << DPAGEBITS) >> 1) - 1] );
+
+	/* translated blocks may hold copies of what was just forgotten */
+	block_flush( hm, a );
+}
+
+void decode_flushall( struct hawk_machine * hm ) {
+	/* invalidate the entire decode cache */
+	memset( hm->dcache, 0,
+		sizeof(struct decoded) * (size_t)(hm->memsize >> 1) );
+	memset( hm->dpage, 0, hm->memsize >> DPAGEBITS );
+	block_flushall( hm );
+}
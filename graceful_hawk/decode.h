@@ -0,0 +1,78 @@
+/* File: decode.h
+   Date: Oct. 16, 2026
+   Language: C (UNIX)
+   Purpose: Hawk Emulator, interface to the instruction predecode cache
+*/
+
+/* assumes prior inclusion of <stdint.h> and "bus.h" */
+
+/***************************
+ * predecoded instructions *
+ ***************************/
+
+/* one entry per halfword of memory; an entry is filled the first time
+   the CPU fetches an instruction from that halfword and remains valid
+   until a store modifies the 256 byte decode page that holds it.
+*/
+struct decoded {
+	WORD imm;       /* sign extended immediate, see decode.c per op */
+	HALF op;        /* handler key, (OP << 4) | OP1, or a pseudo-op */
+	BYTE dst;       /* DST field */
+	BYTE s1;        /* S1 field, also OP1 */
+	BYTE s2;        /* S2 field, also SRC and X */
+	BYTE len;       /* instruction length in bytes, 0 if not decoded */
+	BYTE fetches;   /* instruction words fetched (memory cycles) */
+};
+
+/* pseudo-op keys for things that are not instructions */
+#define OP_BUSFETCH 0x100 /* instruction fetch ran off end of memory */
+#define NUMOPS      0x101
+
+/* decode pages are smaller than MMU pages so that code and nearby
+   data rarely share one; a store into a page flushes the whole page
+*/
+#define DPAGEBITS 8
+
+/* the cache of a machine's memory is its dcache field, with one byte per
+   decode page in its dpage field telling if the page holds any decoded
+   instructions, see machine.h; machines that share memory share these */
+
+/* get the decoded record for the instruction at a, with a < memsize,
+   from the cache of machine h, or from c, a copy of h->dcache that may
+   be in a register */
+#define DECODED(h,a) DECODEDIN( h, (h)->dcache, a )
+#define DECODEDIN(h,c,a) ( DECODEDLEN( &(c)[(a) >> 1] )		\
+			 ? &(c)[(a) >> 1] : decode_fill( h, a ) )
+
+/* with more than one core, a length is read only once the rest of its
+   record is there, see decode_fill and smp.h */
+#ifdef SMP
+#define DECODEDLEN(d) __atomic_load_n( &(d)->len, __ATOMIC_ACQUIRE )
+#else
+#define DECODEDLEN(d) ((d)->len)
+#endif
+
+/* note a store into m[a]; cheap unless the page holds decoded code */
+#define DECODE_STORE(h,a) {					\
+	if ((h)->dpage[(a) >> DPAGEBITS]) decode_flush( h, a );	\
+}
+
+void decode_init( struct hawk_machine * hm );
+/* allocate the cache of hm, once powerup has set its memsize */
+
+void decode_free( struct hawk_machine * hm );
+/* give back the cache of hm, when hm is done with, see libhawk.h */
+
+struct decoded * decode_fill( struct hawk_machine * hm, WORD a );
+/* decode the instruction in m[a], a < memsize, into the cache */
+
+struct decoded * decode_split( struct hawk_machine * hm, WORD a, WORD a2 );
+/* decode the instruction in m[a], with its second halfword, if any, in
+   m[a2], into a scratch record of hm good until the next call; used when
+   the MMU maps the two halfwords to different frames, see cpu.c */
+
+void decode_flush( struct hawk_machine * hm, WORD a );
+/* invalidate the decode page holding m[a] */
+
+void decode_flushall( struct hawk_machine * hm );
+/* invalidate the entire decode cache */
@@ -2,6 +2,8 @@
    Author: Douglas Jones, Dept. of Comp. Sci., U. of Iowa, Iowa City, IA 52242.
    Date: Aug. 21, 2011
    Revised: Nov.  8, 2023 -- add float_acc() for console display of state
+   Revised: Oct. 16, 2026 -- one coprocessor per core, see smp.h
+   Revised: Oct. 16, 2026 -- state held in the machine, see machine.h
 
    Language: C (UNIX)
    Purpose: Hawk floating point coprocessor
@@ -12,15 +14,23 @@
 #include <inttypes.h>
 #include <math.h>
 #include "bus.h"
+#include "decode.h"
+#include "block.h"
+#include "mmu.h"
 #include "float.h"
+#include "machine.h"
 
 
 /************************************************************/
 /* Declarations of coprocessor state not included in bus.h  */
 /************************************************************/
 
-double fpa[2];	/* two floating accumulators, always in long format */
-WORD fplow;
+/* two floating accumulators, always in long format, and the low half
+   of a long operand, all fields of the machine hm, see machine.h */
+#define fpa    (hm->fpa)
+#define fplow  (hm->fplow)
+#define costat (hm->costat)
+#define cocc   (hm->cocc)
 
 /* bit in COSTAT */
 #define FPLONG 0x01000
@@ -29,12 +39,12 @@ WORD fplow;
 /* Interface */
 /*************/
 
-double float_acc( int i ) {
+double float_acc( struct hawk_machine * hm, int i ) {
 	/* read-only access to floating point accumulators for front panel */
 	return fpa[i];
 }
 
-void float_coset( int reg, WORD val ) {
+void float_coset( struct hawk_machine * hm, int reg, WORD val ) {
 	/* coprocesor operation initiated by CPU */
 	int a = reg & 1;
 	int r = reg >> 1;
@@ -99,7 +109,7 @@ void float_coset( int reg, WORD val ) {
 	}
 }
 
-WORD float_coget( int reg ) {
+WORD float_coget( struct hawk_machine * hm, int reg ) {
 	/* coprocesor operation initiated by CPU */
 	int a = reg & 1;
 	int r = reg >> 1;
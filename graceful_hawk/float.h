@@ -2,6 +2,9 @@
    Author: Douglas Jones, Dept. of Comp. Sci., U. of Iowa, Iowa City, IA 52242.
    Date: Aug. 21, 2011
    Revised:  Nov. 8, 2023 - added float_acc for front panel display
+   Revised:  Oct. 16, 2026 - export fpa and fplow for snapshots
+   Revised:  Oct. 16, 2026 - one coprocessor per core, see smp.h
+   Revised:  Oct. 16, 2026 - state held in the machine, see machine.h
 
    Language: C (UNIX)
    Purpose: Hawk floating point coprocessor interface definitions 
@@ -9,11 +12,14 @@
 
 /* assumes prior inclusion of <stdint.h> and "bus.h" */
 
-double float_acc( int i );
+/* the coprocessor state, fpa and fplow, is part of the machine, as
+   are costat and cocc; each function works on the machine hm */
+
+double float_acc( struct hawk_machine * hm, int i );
         /* read-only access to floating point accumulators for front panel */
 
-void float_coset( int reg, WORD val );
+void float_coset( struct hawk_machine * hm, int reg, WORD val );
         /* coprocesor operation initiated by CPU */
 
-WORD float_coget( int reg );
+WORD float_coget( struct hawk_machine * hm, int reg );
         /* coprocesor operation initiated by CPU */
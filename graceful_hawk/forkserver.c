@@ -0,0 +1,273 @@
+/* File: forkserver.c
+   Date: Oct. 16, 2026
+   Language: C (UNIX)
+   Purpose: Hawk Emulator, fork server;
+		runs the program on from the breakpoint once per job,
+		each job in a child process forked at the breakpoint,
+		and reports the final state of each.
+*/
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include "bus.h"
+#include "decode.h"
+#include "block.h"
+#include "mmu.h"
+#include "machine.h"
+#include "forkserver.h"
+
+/*****************
+ * inputs        *
+ *****************/
+
+/* the inputs of the job being started, parsed before it is forked, so
+   that all the child has left to do is to apply them */
+#define INPC  16 /* set PC; 1 to 15 set R1 to RF */
+#define INMEM 17 /* store into memory */
+
+struct input {
+	int what;  /* the register, INPC or INMEM */
+	WORD addr; /* for INMEM, where to store */
+	WORD val;
+};
+
+static struct input * in = NULL;
+static int nin = 0;
+static int inmax = 0;
+
+static void fail( const char * name, const char * why ) {
+	fputs( progname, stderr );
+	fputs( " -F ", stderr );
+	fputs( name, stderr );
+	fputs( why, stderr );
+	exit( EXIT_FAILURE ); /* error */
+}
+
+static void add( int what, WORD addr, WORD val ) {
+	/* add an input to the job */
+	if (nin >= inmax) {
+		inmax = (inmax * 2) + 16;
+		in = realloc( in, sizeof( struct input ) * inmax );
+		if (in == NULL) fail( "", ": out of memory\n" );
+	}
+	in[nin].what = what;
+	in[nin].addr = addr;
+	in[nin].val = val;
+	nin++;
+}
+
+static int number( const char * s, WORD * n ) {
+	/* parse s, in decimal or 0x hex, into n; returns zero if bad */
+	char * e;
+	*n = (WORD)strtoul( s, &e, 0 );
+	return (e != s) && (*e == '\0');
+}
+
+static const char * parse( struct hawk_machine * hm, char * w ) {
+	/* parse the inputs for hm, from w to the end of its line, into in;
+	   returns NULL, or what was wrong with them */
+	nin = 0;
+	for (; w != NULL; w = strtok( NULL, " \t\r\n" )) {
+		char * v = strchr( w, '=' );
+		WORD n;
+		if (v == NULL) return "no = in input";
+		*v++ = '\0';
+		if (((w[0] == 'R') || (w[0] == 'r')) && (w[1] != '\0')
+		&&  (w[2] == '\0') && (strchr( "123456789ABCDEFabcdef",
+					       w[1] ) != NULL)) {
+			if (!number( v, &n )) return "bad register value";
+			add( (int)strtol( w + 1, NULL, 16 ), 0, n );
+		} else if (!strcmp( w, "PC" ) || !strcmp( w, "pc" )) {
+			if (!number( v, &n ) || (n & 1)
+			||  ((n >= hm->memsize) && !(hm->psw & MMUON))) {
+				return "bad PC";
+			}
+			add( INPC, 0, n );
+		} else {
+			WORD a;
+			char * val;
+			char * rest;
+			if (!number( w, &a ) || (a & 3)) return "bad address";
+			for (val = strtok_r( v, ",", &rest ); val != NULL;
+			     val = strtok_r( NULL, ",", &rest )) {
+				if (a >= hm->memsize) return "bad address";
+				if (!number( val, &n )) return "bad value";
+				add( INMEM, a, n );
+				a += 4;
+			}
+		}
+	}
+	return NULL;
+}
+
+static void apply( struct hawk_machine * hm ) {
+	/* apply the inputs to hm in the child */
+	int i;
+	for (i = 0; i < nin; i++) {
+		if (in[i].what == INMEM) {
+			hm->m[in[i].addr >> 2] = in[i].val;
+			DECODE_STORE( hm, in[i].addr );
+		} else if (in[i].what == INPC) {
+			hm->pc = in[i].val;
+		} else {
+			hm->r[in[i].what] = in[i].val;
+		}
+	}
+}
+
+/*****************
+ * results       *
+ *****************/
+
+/* each job that is running has a slot; its result is in memory shared
+   with the child, so the child hands it over without any copying or
+   parsing of its batch report */
+struct result {
+	const char * why;       /* why it stopped, NULL until it reports */
+	int status;             /* the exit status, see batch.h */
+	WORD pc;
+	WORD psw;
+	WORD r[16];
+	WORD cycles;
+	uint64_t instructions;
+};
+
+struct slot {
+	pid_t pid;              /* the child running the job, 0 if free */
+	char * name;            /* the job's name */
+	struct timespec start;  /* when it was forked */
+};
+
+static struct result * results; /* one per slot, shared with children */
+static struct slot * slots;
+static int nslots;
+static int running = 0;         /* how many slots are in use */
+static int failed = 0;          /* how many jobs did not pass */
+
+static struct result * mine = NULL; /* in a child, its result */
+
+static void error( const char * name, const char * why, double secs ) {
+	/* put the result line for a job that did not run to the end */
+	int i;
+	printf( "%s\terror\t%s", name, why );
+	for (i = 0; i < 19; i++) fputs( "\t-", stdout );
+	printf( "\t%.6f\n", secs );
+	failed++;
+}
+
+static void reap() {
+	/* wait for a job to finish and put its result line to stdout */
+	struct timespec now;
+	struct result * r;
+	struct slot * s;
+	double secs;
+	int status;
+	pid_t pid;
+	int i;
+
+	pid = wait( &status );
+	if (pid < 0) fail( "", ": lost a job\n" );
+	clock_gettime( CLOCK_MONOTONIC, &now );
+	for (i = 0; (i < nslots) && (slots[i].pid != pid); i++);
+	if (i >= nslots) return; /* not one of ours */
+	s = &slots[i];
+	r = &results[i];
+	secs = (double)(now.tv_sec - s->start.tv_sec)
+	     + (double)(now.tv_nsec - s->start.tv_nsec) / 1e9;
+
+	if ((r->why == NULL) || !WIFEXITED( status )) {
+		error( s->name, WIFSIGNALED( status ) ? "killed" : "-", secs );
+	} else {
+		printf( "%s\t%s\t%s\t%08"PRIX32"\t%08"PRIX32, s->name,
+			(r->status == EXIT_SUCCESS) ? "pass" : "limit",
+			r->why, r->pc, r->psw );
+		for (i = 1; i < 16; i++) printf( "\t%08"PRIX32, r->r[i] );
+		printf( "\t%"PRIu32"\t%"PRIu64"\t%.6f\n",
+			r->cycles, r->instructions, secs );
+		if (r->status != EXIT_SUCCESS) failed++;
+	}
+	free( s->name );
+	s->pid = 0;
+	running--;
+}
+
+/*************
+ * Interface *
+ *************/
+
+void forkserver_run( struct hawk_machine * hm, const char * inputs ) {
+	/* run the jobs in inputs, returning only in their children */
+	FILE * f = stdin;
+	char * line = NULL;
+	size_t size = 0;
+	int i;
+
+	if (strcmp( inputs, "-" )) f = fopen( inputs, "r" );
+	if (f == NULL) fail( inputs, ": cannot open inputs\n" );
+	nslots = workers;
+	if (nslots <= 0) nslots = (int)sysconf( _SC_NPROCESSORS_ONLN );
+	if (nslots <= 0) nslots = 1;
+	results = mmap( NULL, sizeof( struct result ) * nslots,
+			PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS,
+			-1, 0 );
+	slots = calloc( nslots, sizeof( struct slot ) );
+	if ((results == MAP_FAILED) || (slots == NULL)) {
+		fail( inputs, ": out of memory\n" );
+	}
+
+	fputs( "job\tresult\tstop\tpc\tpsw", stdout );
+	for (i = 1; i < 16; i++) printf( "\tR%X", i );
+	fputs( "\tcycles\tinstructions\tseconds\n", stdout );
+
+	while (getline( &line, &size, f ) >= 0) {
+		char * name = strtok( line, " \t\r\n" );
+		const char * bad;
+		pid_t pid;
+
+		if ((name == NULL) || (*name == '#')) continue;
+		bad = parse( hm, strtok( NULL, " \t\r\n" ) );
+		if (bad != NULL) {
+			error( name, bad, 0.0 );
+			continue;
+		}
+
+		while (running >= nslots) reap();
+		for (i = 0; slots[i].pid != 0; i++); /* a free slot */
+		results[i].why = NULL;
+		fflush( stdout ); /* or the child would inherit its buffer */
+		clock_gettime( CLOCK_MONOTONIC, &slots[i].start );
+		pid = fork();
+		if (pid < 0) fail( name, ": cannot fork\n" );
+		if (pid == 0) { /* this is the job */
+			mine = &results[i];
+			apply( hm );
+			return;
+		}
+		slots[i].pid = pid;
+		slots[i].name = strdup( name );
+		running++;
+	}
+	while (running > 0) reap();
+	exit( (failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE );
+}
+
+void forkserver_report( struct hawk_machine * hm, const char * why,
+			int status, WORD cycles, uint64_t instructions ) {
+	/* in a job, hand its result to the server */
+	if (mine == NULL) return;
+	mine->status = status;
+	mine->pc = hm->pc;
+	mine->psw = hm->psw;
+	memcpy( mine->r, hm->r, sizeof( mine->r ) );
+	mine->cycles = cycles;
+	mine->instructions = instructions;
+	mine->why = why;
+	_exit( status ); /* without flushing what stdio has from the server */
+}
@@ -0,0 +1,52 @@
+/* File: forkserver.h
+   Date: Oct. 16, 2026
+   Language: C (UNIX)
+   Purpose: Hawk Emulator, interface to the fork server
+*/
+
+/* assumes prior inclusion of <stdint.h> and "bus.h" */
+
+/*****************
+ * fork server   *
+ *****************/
+
+/* -F inputs runs the program once in batch mode, see batch.h, up to
+   the breakpoint, set by the object file or by -B, one of which must set
+   it, then runs it on from there once for each job in the file inputs,
+   or stdin if inputs is -.
+   Each job runs in a child process forked from that point, so it
+   starts with a copy-on-write copy of memory instead of loading and
+   running the program up to there again.  Up to -j jobs run at a time,
+   by default one per host CPU.  Each line of inputs is one job:
+
+	name  input ...
+
+   where each input is Rx=value, setting register Rx, 1 to F, PC=value,
+   or address=value,value,..., storing the values in successive words
+   of memory from address; values and addresses are in decimal or 0x
+   hex.  Blank lines and lines starting with # are ignored.  A job runs
+   until PC = 0, the breakpoint comes around again or the limits from
+   -C or -I, which count from the breakpoint, are reached.
+
+   as each job finishes, one tab separated line is put to stdout, under
+   a header line, in the same form as for -J, see jobs.h:
+
+	job  result  stop  pc  psw  R1 ... RF  cycles  instructions  seconds
+
+   where result is pass, limit if the job ran out of cycles or
+   instructions, or error if it did not run to the end or its line was
+   bad; cycles and instructions count from the breakpoint.  The exit
+   status is EXIT_FAILURE unless every job passed.
+*/
+
+void forkserver_run( struct hawk_machine * hm, const char * inputs );
+/* called from batch_console at the breakpoint of hm; returns only in
+   the child process for a job, with its inputs applied to hm, and
+   otherwise exits once every job is done */
+
+void forkserver_report( struct hawk_machine * hm, const char * why,
+			int status, WORD cycles, uint64_t instructions );
+/* called from batch mode when hm stops, for why, with the
+   exit status status, having used cycles and instructions; in the
+   child for a job, hands the result to the server and exits, and
+   otherwise returns */
@@ -23,6 +23,7 @@ char* curr_banner_right;
 static void init_themes();
 void set_banner_style(int incre);
 static void start_theme(int t);
+static void theme_name(int t);
 
 /*******************
  * theme defs *
@@ -48,7 +49,8 @@ struct theme{
 };
 typedef struct theme theme;
 
-static theme themes[num_of_themes];
+//indexed by theme, t_default up to num_of_themes
+static theme themes[num_of_themes + 1];
 
 static float mr = 1;
 static float mg = 1;
@@ -68,22 +70,64 @@ void change_theme(int theme){
 }
 
 
-void print_colorful_nums(uint32_t ints){
+/*******************
+ * hex numbers as runs of cells *
+ *******************/
+static const char hexdigits[16] = {
+	'0', '1', '2', '3', '4', '5', '6', '7',
+	'8', '9', 'A', 'B', 'C', 'D', 'E', 'F'
+};
+
+//the value of each hex digit plus 1, 0 for any other character
+static const char hexvalues[128] = {
+	['0'] = 1, ['1'] = 2, ['2'] = 3, ['3'] = 4, ['4'] = 5,
+	['5'] = 6, ['6'] = 7, ['7'] = 8, ['8'] = 9, ['9'] = 10,
+	['A'] = 11, ['B'] = 12, ['C'] = 13, ['D'] = 14, ['E'] = 15, ['F'] = 16
+};
 
-	for (int i = 7; i>= 0;i--){
-		uint32_t temp_num = (ints >> 4 * i) &0xF;
-		int color_index = temp_num + p_nums;
-		attron(COLOR_PAIR(color_index));
-		printw("%1X",temp_num);
-		attroff(COLOR_PAIR(color_index));
+static void print_run(chtype * run, int n){
+	//one curses call for the whole run, then move past it as printw would
+	int y, x;
+	getyx(stdscr, y, x);
+	addchnstr(run, n);
+	move(y, x + n);
+}
+
+void print_colorful_nums(uint32_t ints){
+	chtype run[8];
+	for (int i = 0; i < 8; i++){
+		uint32_t temp_num = (ints >> 4 * (7 - i)) & 0xF;
+		run[i] = hexdigits[temp_num] | COLOR_PAIR(p_nums + temp_num);
 	}
+	print_run(run, 8);
 }
 
-static void create_pair_bg_b(int index, int r, int g, int b){
-	init_color(index, r, g, b);
-	init_pair(index, index, COLOR_BLACK);
+void print_plain_nums(uint32_t ints, int color_num){
+	chtype run[8];
+	for (int i = 0; i < 8; i++){
+		run[i] = hexdigits[(ints >> 4 * (7 - i)) & 0xF] | COLOR_PAIR(color_num);
+	}
+	print_run(run, 8);
 }
 
+chtype colorful_char(unsigned char c){
+	//a cell for display byte c; control bytes, which would end the
+	//run at a NUL or reach the terminal raw, and bytes past ASCII,
+	//which would spill into the attributes, become plain stand-ins,
+	//^X as X the way batch.c shows them, the rest as ?
+	int v;
+	if (c < ' '){
+		return c | '@';
+	}
+	if (c >= 0x7F){
+		return '?';
+	}
+	v = hexvalues[c];
+	if (cn_on && (v != 0)){
+		return c | COLOR_PAIR(p_nums + v - 1);
+	}
+	return c;
+}
 
 static int mod_color_val(int color, float m){
 	int new_color = (int) color * m;
@@ -136,30 +180,121 @@ void debug(WORD var){
 	mod_b += (end_b - mod_b)/steps; 
 
 
-static void init_colorful_numbers_color_pairs(){
-	theme t = themes[curr_theme];
-	float mod_r= t.n_mod0[0];
-	float mod_g= t.n_mod0[1];
-	float mod_b= t.n_mod0[2];
+/*******************
+ * palettes, every theme's colors worked out once *
+ *******************/
+//each palette is PALETTE_SIZE colors: the colors of the 12 pairs in
+//ui_pairs, then the 16 colorful numbers, then 6 banner colors for each
+//banner style.  The pairs always use the same colors, so a theme is
+//started by loading only those of its colors that differ from the
+//colors loaded, and the banner is turned by pointing its pairs at
+//other colors
+#define PAL_NUMS 12
+#define PAL_BANNERS 28
+#define PALETTE_SIZE (PAL_BANNERS + 3 * banner_len)
+
+static const int ui_pairs[PAL_NUMS] = {
+	p_title, p_status_text, p_status_num, p_register_text,
+	p_register_num, p_memory_add, p_memory_text, p_memory_num,
+	p_menu, p_cpu_line, p_theme_txt, p_memory_line
+};
+
+//the banner colors of each style, before the theme's mr, mg and mb
+static const short banner_rgb[3][banner_len][3] = {
+	[bs_disco] = {
+		{700, 400, 600}, {400, 800, 500}, {800, 700, 500},
+		{500, 400, 800}, {600, 800, 500}, {700, 600, 850}
+	},
+	[bs_gradient] = {
+		{1000, 800, 550}, {800, 850, 750}, {775, 700, 850},
+		{500, 700, 1000}, {750, 800, 900}, {800, 600, 950}
+	},
+	[bs_alternating] = {
+		{600, 700, 900}, {600, 700, 900}, {600, 700, 900},
+		{900, 600, 700}, {900, 600, 700}, {900, 600, 700}
+	}
+};
+
+static short palettes[num_of_themes + 1][PALETTE_SIZE][3];
+static int shown_theme = t_default; //whose palette is loaded
+
+//the colors loaded, as palette colors 0 up to PAL_BANNERS + banner_len,
+//the last being the banner colors of the banner style; -1 if not yet
+static short loaded[PAL_BANNERS + banner_len][3];
+
+static void set_rgb(short * c, int r, int g, int b){
+	c[0] = r;
+	c[1] = g;
+	c[2] = b;
+}
 
+static void make_palette(int t){
+	//work out theme t's palette, once; theme_name(t) sets mr, mg and mb
+	theme th = themes[t];
+	short (*pal)[3] = palettes[t];
+	int (*ui[PAL_NUMS])[3] = {
+		&th.title, &th.status_text, &th.status_num, &th.register_text,
+		&th.register_num, &th.memory_add, &th.memory_text, &th.memory_num,
+		&th.menu, &th.cpu_line, &th.theme_txt, &th.memory_line
+	};
+	float mod_r= th.n_mod0[0];
+	float mod_g= th.n_mod0[1];
+	float mod_b= th.n_mod0[2];
+
+	for (int i = 0; i < PAL_NUMS; i++){
+		set_rgb(pal[i], (*ui[i])[0], (*ui[i])[1], (*ui[i])[2]);
+	}
 	for (int i =0; i<16; i++){
-		init_color(p_nums + i, mod_color_val(650, mod_r), mod_color_val(650, mod_g), mod_color_val(650, mod_b));
-		init_pair(p_nums + i, COLOR_BLACK, p_nums + i);
+		set_rgb(pal[PAL_NUMS + i], mod_color_val(650, mod_r), mod_color_val(650, mod_g), mod_color_val(650, mod_b));
 		switch (i){
 			case 0 ...5:
-				mod_colors_towards( t.n_mod1[0], t.n_mod1[1], t.n_mod1[2], 6);
+				mod_colors_towards( th.n_mod1[0], th.n_mod1[1], th.n_mod1[2], 6);
 				break;
 			case 6 ...11:
-				mod_colors_towards( t.n_mod2[0], t.n_mod2[1], t.n_mod2[2], 6);
+				mod_colors_towards( th.n_mod2[0], th.n_mod2[1], th.n_mod2[2], 6);
 				break;
 
 			case 12 ...15:
-				mod_colors_towards( t.n_mod3[0], t.n_mod3[1], t.n_mod3[2], 4);
+				mod_colors_towards( th.n_mod3[0], th.n_mod3[1], th.n_mod3[2], 4);
 
 		}
+	}
+	for (int b = 0; b < 3; b++){
+		for (int i = 0; i < banner_len; i++){
+			const short * c = banner_rgb[b][i];
+			set_rgb(pal[PAL_BANNERS + b * banner_len + i], mod_color_val(c[0], mr), mod_color_val(c[1], mg), mod_color_val(c[2], mb));
+		}
+	}
+}
 
+static void load_color(int i, int color, const short * rgb){
+	//make color, palette color i, rgb, unless it already is
+	short * c = loaded[i];
+	if ((c[0] == rgb[0]) && (c[1] == rgb[1]) && (c[2] == rgb[2])) return;
+	init_color(color, rgb[0], rgb[1], rgb[2]);
+	set_rgb(c, rgb[0], rgb[1], rgb[2]);
+}
+
+static void load_banner(){
+	//load the banner colors of the banner style
+	short (*pal)[3] = palettes[shown_theme];
+	for (int i = 0; i < banner_len; i++){
+		load_color(PAL_BANNERS + i, banner_temp + i, pal[PAL_BANNERS + curr_banner_style * banner_len + i]);
+	}
+}
+
+static void load_palette(int t){
+	//load the colors of theme t's palette that are not already loaded
+	short (*pal)[3] = palettes[t];
+	for (int i = 0; i < PAL_NUMS; i++){
+		load_color(i, ui_pairs[i], pal[i]);
+	}
+	for (int i = 0; i < 16; i++){
+		load_color(PAL_NUMS + i, p_nums + i, pal[PAL_NUMS + i]);
 	}
+	load_banner();
 }
+
 void switch_colorful_nums(){
 	cn_on = !cn_on;
 	//init_cn_color_pairs();
@@ -172,10 +307,22 @@ void switch_colorful_nums(){
 
 void init_themes_and_color_pairs(){
 	init_themes();
+	for (int t = t_default; t <= num_of_themes; t++){
+		theme_name(t);
+		make_palette(t);
+	}
+	memset(loaded, -1, sizeof(loaded));
+	for (int i = 0; i < PAL_NUMS; i++){
+		init_pair(ui_pairs[i], ui_pairs[i], COLOR_BLACK);
+	}
+	for (int i = 0; i < 16; i++){
+		init_pair(p_nums + i, COLOR_BLACK, p_nums + i);
+	}
 	start_theme(t_default);
+	set_banner_colors();
 }
 
-static void start_theme(int t){
+static void theme_name(int t){
 	switch (t){
 		case t_desert:
 			theme_str = "dune";
@@ -209,22 +356,13 @@ static void start_theme(int t){
 			break;
 	}
 
-	create_pair_bg_b(p_title, themes[t].title[0], themes[t].title[1], themes[t].title[2]);
-	create_pair_bg_b(p_status_text, themes[t].status_text[0], themes[t].status_text[1], themes[t].status_text[2]);
-	create_pair_bg_b(p_status_num, themes[t].status_num[0], themes[t].status_num[1], themes[t].status_num[2]);
-	create_pair_bg_b(p_register_text, themes[t].register_text[0], themes[t].register_text[1], themes[t].register_text[2]);
-	create_pair_bg_b(p_register_num, themes[t].register_num[0], themes[t].register_num[1], themes[t].register_num[2]);
-	create_pair_bg_b(p_memory_add, themes[t].memory_add[0], themes[t].memory_add[1], themes[t].memory_add[2]);
-	create_pair_bg_b(p_memory_text, themes[t].memory_text[0], themes[t].memory_text[1], themes[t].memory_text[2]);
-	create_pair_bg_b(p_memory_num, themes[t].memory_num[0], themes[t].memory_num[1], themes[t].memory_num[2]);
-	create_pair_bg_b(p_menu, themes[t].menu[0], themes[t].menu[1], themes[t].menu[2]);
-	create_pair_bg_b(p_cpu_line, themes[t].cpu_line[0], themes[t].cpu_line[1], themes[t].cpu_line[2]);
-	create_pair_bg_b(p_theme_txt, themes[t].theme_txt[0], themes[t].theme_txt[1], themes[t].theme_txt[2]);
-	create_pair_bg_b(p_memory_line, themes[t].memory_line[0], themes[t].memory_line[1], themes[t].memory_line[2]);
-
-	init_colorful_numbers_color_pairs();
+}
+
+static void start_theme(int t){
+	theme_name(t);
+	shown_theme = t;
 	set_banner_style(0);
-	set_banner_colors();
+	load_palette(t);
 }
 
 #define t_rgb(theme, r, g, b) \
@@ -331,34 +469,17 @@ void set_banner_style(int incre){
 			curr_banner_char = "$";
 			curr_banner_left = "\\";
 			curr_banner_right = "/";
-			init_color(banner_temp + 0, mod_color_val(700, mr), mod_color_val(400, mg), mod_color_val(600, mb));
-			init_color(banner_temp + 1, mod_color_val(400, mr), mod_color_val(800, mg), mod_color_val(500, mb));
-			init_color(banner_temp + 2, mod_color_val(800, mr), mod_color_val(700, mg), mod_color_val(500, mb));
-			init_color(banner_temp + 3, mod_color_val(500, mr), mod_color_val(400, mg), mod_color_val(800, mb));
-			init_color(banner_temp + 4, mod_color_val(600, mr), mod_color_val(800, mg), mod_color_val(500, mb));
-			init_color(banner_temp + 5, mod_color_val(700, mr), mod_color_val(600, mg), mod_color_val(850, mb));
 			break;
 		case bs_gradient:
 			curr_banner_char = "~";
 			curr_banner_left = "/";
 			curr_banner_right = "\\";
-			init_color(banner_temp + 0, mod_color_val(1000, mr), mod_color_val(800, mg), mod_color_val(550, mb));
-			init_color(banner_temp + 1, mod_color_val(800, mr), mod_color_val(850, mg), mod_color_val(750, mb));
-			init_color(banner_temp + 2, mod_color_val(775, mr), mod_color_val(700, mg), mod_color_val(850, mb));
-			init_color(banner_temp + 3, mod_color_val(500, mr), mod_color_val(700, mg), mod_color_val(1000, mb));
-			init_color(banner_temp + 4, mod_color_val(750, mr), mod_color_val(800, mg), mod_color_val(900, mb));
-			init_color(banner_temp + 5, mod_color_val(800, mr), mod_color_val(600, mg), mod_color_val(950, mb));
 			break;
 		case bs_alternating:
 			curr_banner_char = "|";
 			curr_banner_left = "-";
 			curr_banner_right = "-";
-			init_color(banner_temp + 0, mod_color_val(600, mr), mod_color_val(700, mg), mod_color_val(900, mb));
-			init_color(banner_temp + 1, mod_color_val(600, mr), mod_color_val(700, mg), mod_color_val(900, mb));
-			init_color(banner_temp + 2, mod_color_val(600, mr), mod_color_val(700, mg), mod_color_val(900, mb));
-			init_color(banner_temp + 3, mod_color_val(900, mr), mod_color_val(600, mg), mod_color_val(700, mb));
-			init_color(banner_temp + 4, mod_color_val(900, mr), mod_color_val(600, mg), mod_color_val(700, mb));
-			init_color(banner_temp + 5, mod_color_val(900, mr), mod_color_val(600, mg), mod_color_val(700, mb));
 			break;
 	}
+	load_banner();
 }
@@ -2,6 +2,8 @@
  * Functions
  *******************/
 void print_colorful_nums(uint32_t ints);
+void print_plain_nums(uint32_t ints, int color_num);
+chtype colorful_char(unsigned char c);
 void change_theme(int theme);
 void debug(uint32_t var);
 void init_themes_and_color_pairs();
@@ -0,0 +1,132 @@
+/* File: hawktrace.c
+   Date: Oct. 16, 2026
+   Language: C (UNIX)
+   Purpose: Hawk Emulator, instruction trace reader;
+		reads a trace written by hawk -X and writes it out as text,
+		one line per instruction, or with -s, just counts it.
+*/
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "bus.h"
+#include "itrace.h"
+
+static const char * name;
+static FILE * f;
+
+static void fail( const char * why ) {
+	fputs( "hawktrace ", stderr );
+	fputs( name, stderr );
+	fputs( why, stderr );
+	exit( EXIT_FAILURE ); /* error */
+}
+
+static int byte() {
+	/* the next byte of the trace, which must be there */
+	int c = getc( f );
+	if (c == EOF) fail( ": truncated\n" );
+	return c;
+}
+
+static WORD varint() {
+	/* the next varint of the trace, see itrace.h */
+	WORD z = 0;
+	int shift = 0;
+	int c;
+	do {
+		c = byte();
+		if (shift < 32) z |= (WORD)(c & 0x7F) << shift;
+		shift += 7;
+	} while (c & 0x80);
+	return z;
+}
+
+static WORD delta() {
+	/* the next difference of the trace, a zigzag encoded varint */
+	WORD z = varint();
+	return UNZIGZAG( z );
+}
+
+int main( int argc, char ** argv ) {
+	int summary = 0;
+	WORD memsize, pc, ea, expect, i;
+	WORD reg[16];
+	WORD * code;
+	uint64_t count = 0, jumps = 0;
+	char magic[8];
+	int c;
+
+	if ((argc == 3) && !strcmp( argv[1], "-s" )) {
+		summary = 1;
+		argv++;
+		argc--;
+	}
+	if (argc != 2) {
+		fputs( "hawktrace [-s] trace\n", stderr );
+		exit( EXIT_FAILURE ); /* error */
+	}
+	name = argv[1];
+	f = fopen( name, "r" );
+	if (f == NULL) fail( ": cannot open\n" );
+
+	for (i = 0; i < 8; i++) magic[i] = byte();
+	if (memcmp( magic, TRACEMAGIC, 8 )) fail( ": not a trace\n" );
+	memsize = 0;
+	for (i = 0; i < 4; i++) memsize |= (WORD)byte() << (i * 8);
+	code = malloc( sizeof( WORD ) * (memsize >> 1) );
+	if (code == NULL) fail( ": out of memory\n" );
+	for (i = 0; i < (memsize >> 1); i++) code[i] = TRNONE;
+	expect = 0;
+	ea = 0;
+	for (i = 0; i < 16; i++) reg[i] = 0;
+
+	/* rebuild each instruction as the writer saw it, see itrace.c */
+	while ((c = getc( f )) != EOF) {
+		int len = (c & TRLONG) ? 4 : 2;
+		WORD ir;
+
+		pc = expect;
+		if (c & TRJUMP) {
+			pc += delta();
+			jumps++;
+		}
+		expect = pc + len;
+		if ((c & TRCODE) || (pc >= memsize)) {
+			ir = 0;
+			for (i = 0; i < len; i++) ir |= (WORD)byte() << (i * 8);
+			if (pc < memsize) code[pc >> 1] = ir;
+		} else {
+			ir = code[pc >> 1];
+		}
+		if (c & TREA) ea += delta();
+		if (c & TRVAL) reg[ir & 0xF] += delta();
+		count++;
+		if (summary) continue;
+
+		printf( "%06"PRIX32"  %04"PRIX32, pc, ir & 0xFFFF );
+		if (len == 4) {
+			printf( " %04"PRIX32, ir >> 16 );
+		} else {
+			printf( "     " );
+		}
+		if (((ir >> 4) & 0xF) == 0xF) { /* memory reference, see showop.c */
+			printf( "  ea=%08"PRIX32, ea );
+		}
+		if (c & TRVAL) {
+			printf( "  R%"PRIX32"=%08"PRIX32, ir & 0xF, reg[ir & 0xF] );
+		}
+		putchar( '\n' );
+	}
+	if (summary) {
+		long bytes = ftell( f );
+		printf( "instructions: %"PRIu64"\n", count );
+		printf( "jumps:        %"PRIu64"\n", jumps );
+		printf( "bytes:        %ld\n", bytes );
+		if (count > 0) {
+			printf( "bytes each:   %.2f\n", (double)bytes / count );
+		}
+	}
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,249 @@
+/* File: itrace.c
+   Date: Oct. 16, 2026
+   Language: C (UNIX, gcc or clang, with -lpthread)
+   Purpose: Hawk Emulator, instruction trace;
+		puts each instruction run in a ring buffer, from which a
+		thread of its own compresses it and writes it to a file.
+*/
+
+#ifdef ITRACE
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include <sched.h>
+#include <time.h>
+#include "bus.h"
+#include "decode.h"
+#include "block.h"
+#include "mmu.h"
+#include "machine.h"
+#include "itrace.h"
+
+/* the ring holds instructions fetched but not yet written; only the CPU
+   stores head and only the writer stores tail, so neither needs a lock */
+#define RINGBITS 16
+#define RINGSIZE (1 << RINGBITS)
+#define RINGMASK (RINGSIZE - 1)
+
+struct irec {
+	WORD pc;  /* its address, plus 1 if it is 4 bytes long */
+	WORD ir;  /* its halfwords, the first in the low half */
+	WORD ea;  /* the effective address, once it has run */
+	WORD val; /* the value in its DST register, once it has run */
+};
+
+struct itrace {
+	struct irec ring[ RINGSIZE ];
+	unsigned int head;     /* the next to fill, stored by the CPU */
+	unsigned int tailseen; /* the CPU's last look at tail */
+	struct irec cur;       /* the instruction now running */
+	int pending;           /* nonzero once cur holds one */
+	char apart[64];        /* keep tail off the cache line of head */
+
+	unsigned int tail;     /* the next to write, stored by the writer */
+	int done;              /* set once the CPU adds no more */
+};
+
+static struct hawk_machine * traced = NULL; /* the machine traced */
+static const char * tracename;
+static pthread_t writer;
+static FILE * f;
+
+static void complain( const char * why ) {
+	fputs( progname, stderr );
+	fputs( " -X ", stderr );
+	fputs( tracename, stderr );
+	fputs( why, stderr );
+}
+
+static void fail( const char * why ) {
+	complain( why );
+	exit( EXIT_FAILURE ); /* error */
+}
+
+/*****************
+ * the CPU end   *
+ *****************/
+
+static WORD half( struct hawk_machine * hm, WORD a ) {
+	/* the halfword at a */
+	WORD w = hm->m[a >> 2];
+	return (a & 2) ? (w >> 16) : (w & 0xFFFF);
+}
+
+static void put( struct itrace * t ) {
+	/* put cur in the ring, waiting for room if need be */
+	unsigned int h = t->head;
+	while ((h - t->tailseen) == RINGSIZE) {
+		t->tailseen = __atomic_load_n( &t->tail, __ATOMIC_ACQUIRE );
+		if ((h - t->tailseen) == RINGSIZE) sched_yield();
+	}
+	t->ring[h & RINGMASK] = t->cur;
+	__atomic_store_n( &t->head, h + 1, __ATOMIC_RELEASE );
+}
+
+static void ran( struct hawk_machine * hm, struct itrace * t ) {
+	/* the instruction in cur has run, put it in the ring */
+	t->cur.ea = hm->ea;
+	t->cur.val = hm->r[t->cur.ir & 0xF]; /* DST, see irfields.h */
+	put( t );
+}
+
+void itrace_fetch( struct hawk_machine * hm, WORD va, WORD pa, int len ) {
+	struct itrace * t = hm->itrace;
+	if (t->pending) ran( hm, t );
+	t->pending = 1;
+	t->cur.pc = va | (len >> 2);
+	if ((pa >= hm->memsize) || ((hm->memsize - pa) < len)) {
+		t->cur.ir = (len == 4) ? TRNONE : (TRNONE & 0xFFFF);
+	} else if (len == 4) {
+		t->cur.ir = half( hm, pa ) | (half( hm, pa + 2 ) << 16);
+	} else {
+		t->cur.ir = half( hm, pa );
+	}
+}
+
+/*****************
+ * the writer    *
+ *****************/
+
+/* the writer's picture of the machine, as the reader will rebuild it */
+static WORD * code;    /* the last instruction at each halfword */
+static WORD expect;    /* where the next instruction should be */
+static WORD lastea;
+static WORD reg[16];
+
+/* output is buffered here, rather than by stdio, which locks */
+static BYTE obuf[ 1 << 16 ];
+static int olen = 0;
+static int broken = 0; /* set once a write fails, the rest are dropped */
+
+static void oflush() {
+	if (!broken && (fwrite( obuf, 1, olen, f ) != (size_t)olen)) {
+		complain( ": cannot write\n" );
+		broken = 1;
+	}
+	olen = 0;
+}
+
+static int varint( BYTE * p, WORD z ) {
+	/* put z in p as a varint, see itrace.h; returns its length */
+	int n = 0;
+	while (z >= 0x80) {
+		p[n++] = (z & 0x7F) | 0x80;
+		z >>= 7;
+	}
+	p[n++] = z;
+	return n;
+}
+
+static void encode( struct irec * e ) {
+	/* compress one instruction into obuf */
+	BYTE * p;
+	BYTE flags = 0;
+	int n = 1;
+	WORD pc = e->pc & ~(WORD)1;
+	WORD dst = e->ir & 0xF;
+
+	if ((olen + 32) > (int)sizeof( obuf )) oflush();
+	p = &obuf[olen];
+	if (e->pc & 1) flags |= TRLONG;
+	if (pc != expect) {
+		flags |= TRJUMP;
+		n += varint( &p[n], ZIGZAG( pc - expect ) );
+	}
+	expect = pc + ((e->pc & 1) ? 4 : 2);
+	if ((pc >= traced->memsize) || (code[pc >> 1] != e->ir)) {
+		int i;
+		flags |= TRCODE;
+		if (pc < traced->memsize) code[pc >> 1] = e->ir;
+		for (i = 0; i < ((e->pc & 1) ? 4 : 2); i++) {
+			p[n++] = e->ir >> (i * 8);
+		}
+	}
+	if (e->ea != lastea) {
+		flags |= TREA;
+		n += varint( &p[n], ZIGZAG( e->ea - lastea ) );
+		lastea = e->ea;
+	}
+	if ((dst != 0) && (e->val != reg[dst])) {
+		flags |= TRVAL;
+		n += varint( &p[n], ZIGZAG( e->val - reg[dst] ) );
+		reg[dst] = e->val;
+	}
+	p[0] = flags;
+	olen += n;
+}
+
+static void * drain( void * arg ) {
+	/* the writer thread, drain the ring until the CPU is done */
+	struct itrace * t = arg;
+	const struct timespec nap = { 0, 100000 }; /* 100 microseconds */
+	unsigned int tail = t->tail;
+
+	for (;;) {
+		int done = __atomic_load_n( &t->done, __ATOMIC_ACQUIRE );
+		unsigned int head = __atomic_load_n( &t->head,
+						     __ATOMIC_ACQUIRE );
+		if (head == tail) {
+			if (done) break;
+			nanosleep( &nap, NULL );
+			continue;
+		}
+		while (tail != head) {
+			encode( &t->ring[tail & RINGMASK] );
+			tail++;
+			if ((tail & 0xFFF) == 0) { /* make room as we go */
+				__atomic_store_n( &t->tail, tail,
+						  __ATOMIC_RELEASE );
+			}
+		}
+		__atomic_store_n( &t->tail, tail, __ATOMIC_RELEASE );
+	}
+	oflush();
+	return NULL;
+}
+
+static void finish() {
+	/* called at exit, put the last instruction and wait for the rest */
+	struct itrace * t = traced->itrace;
+	if (t->pending) ran( traced, t );
+	__atomic_store_n( &t->done, 1, __ATOMIC_RELEASE );
+	pthread_join( writer, NULL );
+	if ((fclose( f ) != 0) && !broken) complain( ": cannot write\n" );
+}
+
+/*************
+ * Interface *
+ *************/
+
+void itrace_start( struct hawk_machine * hm, const char * trace ) {
+	struct itrace * t;
+	BYTE head[12];
+	WORD i;
+
+	tracename = trace;
+	traced = hm;
+	f = fopen( trace, "w" );
+	if (f == NULL) fail( ": cannot open\n" );
+	t = calloc( 1, sizeof( struct itrace ) );
+	code = malloc( sizeof( WORD ) * (hm->memsize >> 1) );
+	if ((t == NULL) || (code == NULL)) fail( ": out of memory\n" );
+	for (i = 0; i < (hm->memsize >> 1); i++) code[i] = TRNONE;
+
+	for (i = 0; i < 8; i++) head[i] = TRACEMAGIC[i];
+	for (i = 0; i < 4; i++) head[8 + i] = hm->memsize >> (i * 8);
+	if (fwrite( head, 1, sizeof( head ), f ) != sizeof( head )) {
+		fail( ": cannot write\n" );
+	}
+
+	if (pthread_create( &writer, NULL, drain, t )) {
+		fail( ": cannot start the writer\n" );
+	}
+	hm->itrace = t;
+	atexit( finish );
+}
+
+#endif
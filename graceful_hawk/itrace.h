@@ -0,0 +1,75 @@
+/* File: itrace.h
+   Date: Oct. 16, 2026
+   Language: C (UNIX)
+   Purpose: Hawk Emulator, interface to the instruction trace
+*/
+
+/* assumes prior inclusion of <stdint.h> and "bus.h" */
+
+/*****************
+ * the trace     *
+ *****************/
+
+/* built with ITRACE, see the Makefile, -X trace writes every instruction
+   run by core 0 to the file trace: its address, the halfwords of the
+   instruction, the effective address left by it, and the value left in
+   the register named by its DST field, which is what it wrote back if
+   it writes one.  Which of these matter to an instruction is up to its
+   opcode; hawktrace reads the trace, see hawktrace.c.  With the MMU on,
+   addresses are virtual; an instruction that spans two pages is shown
+   as FFFF halfwords.  The block engine and the JIT do not run one
+   instruction at a time, so with -X the switch engine runs in their
+   place.
+
+   the CPU only puts each instruction in a ring buffer; a thread of its
+   own takes them out, compresses them and writes them, waiting for
+   the CPU only when the ring is empty, as the CPU waits for it only
+   when the ring is full.  The ring is drained when the emulator exits.
+*/
+
+/* the trace is written little endian, starting with a header:
+
+	TRACEMAGIC   8 bytes
+	memsize      4 bytes
+
+   then one record per instruction, starting with a byte of TR flags,
+   then the fields that the flags call for, in this order:
+
+	TRJUMP  pc - (previous pc + previous length), as a varint
+	TRCODE  the instruction, 2 or 4 bytes as TRLONG says
+	TREA    ea - previous ea, as a varint
+	TRVAL   value - previous value of the same register, as a varint
+
+   TRCODE is given for an instruction at pc < memsize only if it differs
+   from the last one at pc, and always for others; both ends start with
+   no instructions known, FFFFFFFF, and all of ea and the registers 0.
+   A varint is a zigzag encoded difference, 7 bits per byte, least
+   significant first, with the top bit set in all but the last byte;
+   most instructions take one or two bytes in all.
+*/
+#define TRACEMAGIC "HAWKTRC1"
+
+#define TRLONG 0x01 /* the instruction is 4 bytes */
+#define TRJUMP 0x02 /* it does not follow the one before */
+#define TRCODE 0x04 /* its halfwords follow */
+#define TREA   0x08 /* the effective address changed */
+#define TRVAL  0x10 /* its DST register changed */
+
+#define TRNONE ((WORD)0xFFFFFFFFUL) /* an instruction not yet known */
+
+/* the zigzag encoding, small differences of either sign are small */
+#define ZIGZAG(d)   (((WORD)(d) << 1) ^ (WORD)(-(int32_t)((WORD)(d) >> 31)))
+#define UNZIGZAG(z) (((WORD)(z) >> 1) ^ (WORD)(-(int32_t)((z) & 1)))
+
+/*****************
+ * tracing       *
+ *****************/
+
+struct hawk_machine;
+
+void itrace_fetch( struct hawk_machine * hm, WORD va, WORD pa, int len );
+/* called as the instruction len bytes long at va, physical pa, is fetched;
+   pa is TRNONE if it is not all in one frame */
+
+void itrace_start( struct hawk_machine * hm, const char * trace );
+/* called from main once powerup is done; trace hm to the file trace */
@@ -0,0 +1,1208 @@
+/* File: jit.c
+   Date: Oct. 16, 2026
+   Language: C (UNIX, x86-64 hosts only)
+   Purpose: Hawk Emulator, block compiler;
+		hot basic blocks found by the block engine are compiled
+		to x86-64 code that keeps the Hawk registers of the block,
+		the cycle count and the PSW in host registers.
+*/
+
+#ifdef JIT
+#ifndef __x86_64__
+#error "the JIT needs an x86-64 host, build without -DJIT"
+#endif
+
+#include <inttypes.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#include "bus.h"
+#include "decode.h"
+#include "block.h"
+#include "mmu.h"
+#include "machine.h"
+#include "jit.h"
+
+/**********************
+ * host code emission *
+ **********************/
+
+/* host registers */
+#define RAX 0
+#define RCX 1
+#define RDX 2
+#define RBX 3
+#define RSP 4
+#define RBP 5
+#define RSI 6
+#define RDI 7
+#define R8  8
+#define R9  9
+#define R10 10
+#define R11 11
+#define R12 12
+#define R13 13
+#define R14 14
+#define R15 15
+
+/* while host code runs, rbp points to r[0] so that all of the emulator's
+   data can be reached by 32 bit displacements from it; r14 holds cycles
+   and r15 holds psw.  rax, rcx, rdx and r11 are scratch, the rest hold
+   Hawk registers, as allocated separately for each block */
+#define CYC R14
+#define PSW R15
+static const int pool[] = { RBX, RSI, RDI, R8, R9, R10, R12, R13 };
+#define POOLSIZE 8
+
+/* condition codes for jcc and setcc */
+#define CC_O  0x0
+#define CC_B  0x2
+#define CC_AE 0x3
+#define CC_E  0x4
+#define CC_NE 0x5
+#define CC_S  0x8
+#define CC_NS 0x9
+#define CC_L  0xC
+
+/* alu operations, as in opcodes 00-3F and 81 /n */
+#define ALU_ADD 0
+#define ALU_OR  1
+#define ALU_ADC 2
+#define ALU_AND 4
+#define ALU_SUB 5
+#define ALU_XOR 6
+#define ALU_CMP 7
+
+/* shift operations, as in C1 /n and D3 /n */
+#define SH_SHL 4
+#define SH_SHR 5
+
+/* operands: a host register, [rbp + displacement], or an immediate */
+#define OREG 0
+#define OMEM 1
+#define OIMM 2
+struct opnd {
+	int kind;
+	int reg;     /* for OREG */
+	int32_t val; /* displacement for OMEM, value for OIMM */
+};
+
+static struct opnd oreg( int r ) {
+	struct opnd o; o.kind = OREG; o.reg = r; o.val = 0; return o;
+}
+static struct opnd omem( int32_t d ) {
+	struct opnd o; o.kind = OMEM; o.reg = RBP; o.val = d; return o;
+}
+static struct opnd oimm( WORD v ) {
+	struct opnd o; o.kind = OIMM; o.reg = 0; o.val = (int32_t)v; return o;
+}
+
+/* what the JIT keeps for one machine, made by jit_init and held in
+   hm->jit, see machine.h; jt is the one in use on this host thread, so
+   that machines run on different threads may each compile and run
+   host code of their own.  The fields are used through the macros
+   below and in the emulator's data, as cpu.c does with the machine */
+struct jit {
+	BYTE * cp;                  /* where the next byte of code goes */
+	struct hawk_machine * jm;   /* the machine */
+	int32_t o_pc, o_psw, o_cycles, o_morecycles, o_breakpoint;
+	int32_t o_instructions, o_counters;
+	int32_t o_btab, o_carries, o_snoop, o_cctab;
+	int bshift;
+	BYTE * code;
+	BYTE * blockcode;
+	BYTE * xit;
+	int (* enter)( void * );
+};
+static __thread struct jit * jt;
+
+#define cp (jt->cp)
+
+#define B(x) (*cp++ = (BYTE)(x))
+
+static void d32( int32_t v ) {
+	memcpy( cp, &v, 4 );
+	cp += 4;
+}
+
+static void rex( int w, int r, int x, int b ) {
+	/* REX prefix, if any is needed */
+	int v = 0x40 | (w << 3) | ((r & 8) >> 1) | ((x & 8) >> 2) | ((b & 8) >> 3);
+	if (v != 0x40) B( v );
+}
+
+static void opcode( int opc ) {
+	/* one byte opcode, or two bytes 0F xx given as 0x0Fxx */
+	if (opc > 0xFF) B( opc >> 8 );
+	B( opc );
+}
+
+static void op_rm( int w, int opc, int reg, struct opnd o ) {
+	/* opc with ModRM, reg field reg (or /n), r/m field o */
+	rex( w, reg, 0, (o.kind == OREG) ? o.reg : 0 );
+	opcode( opc );
+	if (o.kind == OREG) {
+		B( 0xC0 | ((reg & 7) << 3) | (o.reg & 7) );
+	} else {
+		B( 0x80 | ((reg & 7) << 3) | RBP );
+		d32( o.val );
+	}
+}
+
+static void op_sib( int w, int opc, int reg, int idx, int scale, int32_t d ) {
+	/* opc with memory operand [rbp + idx*(1<<scale) + d] */
+	rex( w, reg, idx, 0 );
+	opcode( opc );
+	B( 0x84 | ((reg & 7) << 3) );
+	B( (scale << 6) | ((idx & 7) << 3) | RBP );
+	d32( d );
+}
+
+static void op_far( int w, int opc, int reg, int idx, void * base ) {
+	/* opc with memory operand [base + idx], for data that may be too
+	   far from rbp for a 32 bit displacement; clobbers r11 */
+	uint64_t a = (uint64_t)(uintptr_t)base;
+	rex( 1, 0, 0, R11 );
+	B( 0xB8 | (R11 & 7) );          /* mov r11, imm64 */
+	memcpy( cp, &a, 8 );
+	cp += 8;
+	rex( w, reg, idx, R11 );
+	opcode( opc );
+	B( 0x04 | ((reg & 7) << 3) );
+	B( ((idx & 7) << 3) | (R11 & 7) );
+}
+
+static void mov_r_o( int r, struct opnd o ) {
+	/* mov r32, o */
+	if (o.kind == OIMM) {
+		rex( 0, 0, 0, r );
+		B( 0xB8 | (r & 7) );
+		d32( o.val );
+	} else if ((o.kind != OREG) || (o.reg != r)) {
+		op_rm( 0, 0x8B, r, o );
+	}
+}
+
+static void mov_o_r( struct opnd o, int r ) {
+	/* mov o, r32 */
+	if ((o.kind != OREG) || (o.reg != r)) op_rm( 0, 0x89, r, o );
+}
+
+static void mov_m_imm( int32_t d, WORD v ) {
+	/* mov dword [rbp + d], imm32 */
+	op_rm( 0, 0xC7, 0, omem( d ) );
+	d32( (int32_t)v );
+}
+
+static void alu_r_o( int n, int r, struct opnd o ) {
+	/* op r32, o */
+	if (o.kind == OIMM) {
+		op_rm( 0, 0x81, n, oreg( r ) );
+		d32( o.val );
+	} else {
+		op_rm( 0, (n << 3) | 3, r, o );
+	}
+}
+
+static void alu_o_r( int n, struct opnd o, int r ) {
+	/* op o, r32 */
+	op_rm( 0, (n << 3) | 1, r, o );
+}
+
+static void alu_o_imm( int n, struct opnd o, WORD v ) {
+	/* op o, imm32 */
+	op_rm( 0, 0x81, n, o );
+	d32( (int32_t)v );
+}
+
+static void shift_imm( int n, int r, int k ) {
+	/* shl or shr r32, k */
+	op_rm( 0, 0xC1, n, oreg( r ) );
+	B( k );
+}
+
+static void shift_cl( int n, int r ) {
+	/* shl or shr r32, cl */
+	op_rm( 0, 0xD3, n, oreg( r ) );
+}
+
+static void not_o( struct opnd o ) { op_rm( 0, 0xF7, 2, o ); }
+static void neg_r( int r ) { op_rm( 0, 0xF7, 3, oreg( r ) ); }
+static void test_r( int r ) { op_rm( 0, 0x85, r, oreg( r ) ); }
+static void test_r64( int r ) { op_rm( 1, 0x85, r, oreg( r ) ); }
+static void zero_r( int r ) { alu_r_o( ALU_XOR, r, oreg( r ) ); }
+static void setcc( int cc, int r ) { op_rm( 0, 0x0F90 | cc, 0, oreg( r ) ); }
+
+static void lea_rs( int r, int base, int idx, int scale ) {
+	/* lea r32, [base + idx*(1<<scale)], base not rbp or r13 */
+	rex( 0, r, idx, base );
+	B( 0x8D );
+	B( 0x04 | ((r & 7) << 3) );
+	B( (scale << 6) | ((idx & 7) << 3) | (base & 7) );
+}
+
+static void lea_rd( int r, int base, int32_t d ) {
+	/* lea r32, [base + d], base not rsp or r12 */
+	rex( 0, r, 0, base );
+	B( 0x8D );
+	B( 0x80 | ((r & 7) << 3) | (base & 7) );
+	d32( d );
+}
+
+static BYTE * jcc( int cc ) {
+	/* jcc rel32, returns the place to patch */
+	B( 0x0F ); B( 0x80 | cc ); d32( 0 );
+	return cp - 4;
+}
+
+static BYTE * jmp() {
+	/* jmp rel32, returns the place to patch */
+	B( 0xE9 ); d32( 0 );
+	return cp - 4;
+}
+
+static void patch( BYTE * at, BYTE * to ) {
+	/* make the rel32 at at point to to */
+	int32_t rel = (int32_t)(to - (at + 4));
+	memcpy( at, &rel, 4 );
+}
+
+/*****************************
+ * the emulator's data       *
+ *****************************/
+
+/* the machine that host code runs */
+#define jm (jt->jm)
+
+/* displacements from jm->r[0] of everything host code touches, except m
+   and dpage, which are wherever the host put them, see op_far */
+#define o_pc           (jt->o_pc)
+#define o_psw          (jt->o_psw)
+#define o_cycles       (jt->o_cycles)
+#define o_morecycles   (jt->o_morecycles)
+#define o_breakpoint   (jt->o_breakpoint)
+#define o_instructions (jt->o_instructions)
+#define o_counters     (jt->o_counters)
+#define o_btab         (jt->o_btab)
+#define o_carries      (jt->o_carries)
+#define o_snoop        (jt->o_snoop)
+#define o_cctab        (jt->o_cctab)
+#define OFF(p) ((char *)(p) - (char *)jm->r)
+
+#define bshift (jt->bshift) /* log2 sizeof(struct block) */
+
+/* the machine's code buffer; the first bytes hold the entry and exit
+   code shared by all of its blocks, the rest fills with blocks until it
+   is full, at which point all blocks are forgotten and it fills again.
+   It is never both writable and executable; the pages a block is
+   compiled into are made writable only while it is compiled, see
+   unlock */
+#define CODESIZE  (16 << 20)
+#define BLOCKCODE (16 << 10)  /* room for the biggest possible block */
+#define code      (jt->code)
+#define blockcode (jt->blockcode) /* the first byte that is not shared code */
+#define xit       (jt->xit)       /* the shared exit code */
+#define enter     (jt->enter)
+
+static int unlock( BYTE * at, int write ) {
+	/* make the pages from at through at + BLOCKCODE writable, if write,
+	   or executable, but not both; returns zero if the host refuses */
+	uintptr_t mask = (uintptr_t)sysconf( _SC_PAGESIZE ) - 1;
+	BYTE * lo = (BYTE *)((uintptr_t)at & ~mask);
+	BYTE * hi = at + BLOCKCODE;
+	if (hi > code + CODESIZE) hi = code + CODESIZE;
+	return mprotect( lo, hi - lo, write ? (PROT_READ | PROT_WRITE)
+					    : (PROT_READ | PROT_EXEC) ) == 0;
+}
+
+int jit_init( struct hawk_machine * hm, unsigned int * cctab ) {
+	/* set up the compiler for hm; return zero if it cannot be used */
+	long lo = 0, hi = 0;
+	long offs[12];
+	int i;
+
+	if (hm->jit != NULL) { /* code stays NULL if it cannot be used */
+		jt = hm->jit;
+		return code != NULL;
+	}
+	hm->jit = calloc( 1, sizeof( struct jit ) );
+	if (hm->jit == NULL) return 0;
+	jt = hm->jit;
+	jm = hm;
+
+	offs[0] = OFF( &hm->pc );
+	offs[1] = OFF( &hm->psw );
+	offs[2] = OFF( &hm->cycles );
+	offs[3] = OFF( &hm->morecycles );
+	offs[4] = OFF( hm->btab );
+	offs[5] = OFF( &hm->btab[ 1 << BHASHBITS ] );
+	offs[6] = OFF( &hm->carries );
+	offs[7] = OFF( &hm->snoop );
+	offs[8] = OFF( &cctab[16] );
+	offs[9] = OFF( &hm->breakpoint );
+	offs[10] = OFF( &hm->instructions );
+	offs[11] = OFF( &hm->counters[0] );
+	for (i = 0; i < 12; i++) {
+		if (offs[i] < lo) lo = offs[i];
+		if (offs[i] > hi) hi = offs[i];
+	}
+	if ((lo < -0x7F000000L) || (hi > 0x7F000000L)) {
+		return 0;
+	}
+	o_pc = offs[0]; o_psw = offs[1];
+	o_cycles = offs[2]; o_morecycles = offs[3];
+	o_btab = offs[4];
+	o_carries = offs[6]; o_snoop = offs[7]; o_cctab = OFF( cctab );
+	o_breakpoint = offs[9]; o_instructions = offs[10];
+	o_counters = offs[11];
+
+	for (bshift = 0; (1 << bshift) < (int)sizeof(struct block); bshift++);
+	if ((1 << bshift) != (int)sizeof(struct block)) {
+		return 0;
+	}
+
+	code = mmap( NULL, CODESIZE, PROT_READ | PROT_WRITE,
+		     MAP_PRIVATE | MAP_ANONYMOUS, -1, 0 );
+	if (code == MAP_FAILED) {
+		code = NULL;
+		return 0;
+	}
+	cp = code;
+
+	/* int enter( void * native ), called from C */
+	B( 0x53 );                      /* push rbx */
+	B( 0x55 );                      /* push rbp */
+	B( 0x41 ); B( 0x54 );           /* push r12 */
+	B( 0x41 ); B( 0x55 );           /* push r13 */
+	B( 0x41 ); B( 0x56 );           /* push r14 */
+	B( 0x41 ); B( 0x57 );           /* push r15 */
+	B( 0x48 ); B( 0xBD );           /* mov rbp, imm64 */
+	{
+		uint64_t base = (uint64_t)(uintptr_t)hm->r;
+		memcpy( cp, &base, 8 );
+		cp += 8;
+	}
+	mov_r_o( CYC, omem( o_cycles ) );
+	mov_r_o( PSW, omem( o_psw ) );
+	B( 0xFF ); B( 0xE7 );           /* jmp rdi */
+
+	/* the exit, with the result in eax */
+	xit = cp;
+	mov_o_r( omem( o_cycles ), CYC );
+	mov_o_r( omem( o_psw ), PSW );
+	B( 0x41 ); B( 0x5F );           /* pop r15 */
+	B( 0x41 ); B( 0x5E );           /* pop r14 */
+	B( 0x41 ); B( 0x5D );           /* pop r13 */
+	B( 0x41 ); B( 0x5C );           /* pop r12 */
+	B( 0x5D );                      /* pop rbp */
+	B( 0x5B );                      /* pop rbx */
+	B( 0xC3 );                      /* ret */
+
+	enter = (int (*)( void * ))(void *)code;
+	blockcode = cp;
+	if (!unlock( code, 0 )) { /* the host will not run generated code */
+		munmap( code, CODESIZE );
+		code = NULL;
+		return 0;
+	}
+	return 1;
+}
+
+/*************************************
+ * what host code can do and where   *
+ *************************************/
+
+/* the instructions of the block being compiled; these, and all of the
+   compiler's other scratch below, belong to the host thread compiling */
+static __thread struct decoded * ins[ 64 ];
+static __thread WORD insaddr[ 64 ];   /* the address of each */
+static __thread WORD inscyc[ 64 ];    /* block memory cycles before each */
+static __thread BYTE insloads[ 65 ];  /* loads before each, see count */
+static __thread BYTE insstores[ 65 ]; /* stores before each */
+static __thread int nins;             /* how many can be compiled */
+
+static int supported( struct decoded * d, WORD a ) {
+	/* can host code do d, found at a, entirely on its own? */
+	switch (d->op) {
+	case 0xFF: /* MOVE */
+		return d->dst != 0;
+	case 0xFE: /* MOVECC */
+	case 0xFD: /* LOADS */
+	case 0xFC: /* LOADSCC */
+	case 0xFB: /* JSRS */
+		return 1;
+	case 0xFA: /* STORES */
+		return d->s2 != 0;
+#ifndef SPARROWHAWK
+	case 0xF7: /* LEA */
+		return d->dst != 0;
+	case 0xF6: /* LEACC */
+	case 0xF5: /* LOAD */
+	case 0xF4: /* LOADCC */
+	case 0xF2: /* STORE */
+		return 1;
+	case 0xF3: /* JSR */
+		return (d->s2 != 0) || ((d->imm + a + 4) < jm->memsize);
+	case 0xE0: /* LIL */
+		return (d->dst != 0) || (d->imm < jm->memsize);
+#endif
+	case 0xD0: /* LIS */
+	case 0xC0: /* ORIS */
+	case 0xA0: /* ADDSL */
+	case 0x70: /* STUFFB */
+	case 0x60: /* STUFFH */
+	case 0x1C: /* ADDSI, not DISPLAY */
+	case 0x19: /* EQU */
+		return d->dst != 0;
+	case 0x1B: /* AND */
+	case 0x1A: /* OR */
+		return (d->dst != 0) && (d->s2 != 0);
+	case 0x90: /* ADDSR */
+		return 1;
+	case 0x50: /* EXTB */
+	case 0x40: /* EXTH */
+		return d->s1 != 0;
+	case 0x30: /* ADD */
+		return (d->s1 != 0) && (d->s2 != 0);
+	case 0x20: /* SUB */
+		return d->s2 != 0;
+	case 0x00: /* Bcc */
+		return (d->dst != 8) && ((a + 2 + d->imm) < jm->memsize);
+	}
+	return 0;
+}
+
+static int flagsetter( struct decoded * d ) {
+	/* does d set all of N Z V C in psw, and carries? */
+	switch (d->op) {
+	case 0xFE: case 0xFC: case 0xF6: case 0xF4:
+	case 0xA0: case 0x90: case 0x50: case 0x40:
+	case 0x30: case 0x20: case 0x1C: case 0x1B: case 0x1A: case 0x19:
+		return 1;
+	}
+	return 0;
+}
+
+static int mayexit( struct decoded * d ) {
+	/* might host code give up on d, or leave the block before it? */
+	switch (d->op) {
+	case 0xFD: case 0xFC: case 0xFA:
+	case 0xF5: case 0xF4: case 0xF2:
+		return 1;
+	case 0xFB: case 0xF3:
+		return d->s2 != 0;
+	}
+	return 0;
+}
+
+/* for each instruction, must it leave psw and carries exactly right? */
+static __thread BYTE pswlive[ 64 ];
+static __thread BYTE carlive[ 64 ];
+
+static void liveness() {
+	/* flags set by one instruction and set again by a later one,
+	   with nothing in between that could look at them, are dead */
+	int p = 1, c = 1; /* all is visible after the block */
+	int i;
+	for (i = nins - 1; i >= 0; i--) {
+		struct decoded * d = ins[i];
+		pswlive[i] = p;
+		carlive[i] = c;
+		if (flagsetter( d )) p = c = 0;
+		if ((d->op == 0x00) && (d->dst != 0)) p = 1; /* Bcc tests */
+		if (mayexit( d )) p = c = 1;
+	}
+}
+
+/* where the Hawk registers live in this block */
+static __thread struct opnd loc[16];
+static __thread WORD inreg;   /* Hawk registers held in host registers */
+static __thread WORD dirty;   /* of those, the ones changed so far */
+
+static void allocate() {
+	/* give host registers to the most used Hawk registers */
+	int uses[16];
+	int i, j;
+	memset( uses, 0, sizeof(uses) );
+	for (i = 0; i < nins; i++) {
+		uses[ ins[i]->dst ]++;
+		uses[ ins[i]->s1 ]++;
+		uses[ ins[i]->s2 ]++;
+	}
+	inreg = 0;
+	for (i = 1; i < 16; i++) loc[i] = omem( i * 4 );
+	for (j = 0; j < POOLSIZE; j++) {
+		int best = 0;
+		for (i = 1; i < 16; i++) {
+			if ((uses[i] > 0) && !(inreg & (1 << i))
+			&&  ((best == 0) || (uses[i] > uses[best]))) best = i;
+		}
+		if (best == 0) break;
+		inreg |= 1 << best;
+		loc[best] = oreg( pool[j] );
+	}
+}
+
+/* r[0] is zeroed before each instruction, and some set it to pc;
+   it is only stored when the block is left normally */
+static __thread WORD r0val; /* the value r[0] would have, unless r0mem */
+static __thread int r0mem;  /* r[0] was stored by the current instruction */
+
+static struct opnd src( int i ) {
+	/* operand for reading Hawk register i */
+	if (i == 0) return oimm( r0val );
+	return loc[i];
+}
+
+static void dst( int i, int h ) {
+	/* Hawk register i = host register h */
+	if (i == 0) {
+		mov_o_r( omem( 0 ), h );
+		r0mem = 1;
+	} else {
+		mov_o_r( loc[i], h );
+		if (inreg & (1 << i)) dirty |= 1 << i;
+	}
+}
+
+static void writeback( WORD which ) {
+	/* store the changed Hawk registers held in host registers */
+	int i;
+	for (i = 1; i < 16; i++) {
+		if (which & (1 << i)) mov_o_r( omem( i * 4 ), loc[i].reg );
+	}
+}
+
+/*************************************
+ * leaving host code                 *
+ *************************************/
+
+/* give-ups, where the interpreter must run an instruction; the code
+   for these goes after the rest of the block, out of the way */
+#define MAXGIVEUPS 128
+static __thread struct giveup {
+	BYTE * at;   /* jcc to patch */
+	int i;       /* the instruction */
+	WORD dirty;  /* Hawk registers to write back */
+} giveups[ MAXGIVEUPS ];
+static __thread int ngiveups;
+
+static void giveup( BYTE * at, int i ) {
+	/* note that the jcc at at gives up before instruction i */
+	giveups[ngiveups].at = at;
+	giveups[ngiveups].i = i;
+	giveups[ngiveups].dirty = dirty;
+	ngiveups++;
+}
+
+static __thread int ndone; /* instructions done when leaving normally */
+
+static void count( int n, int taken ) {
+	/* count n more instructions, the loads and stores among them, and
+	   a branch if taken, as the performance counters do, see bus.h */
+	if (n != 0) {
+		op_rm( 1, 0x81, 0, omem( o_instructions ) ); /* add qword */
+		d32( n );
+	}
+	if (insloads[n] != 0) {
+		alu_o_imm( ALU_ADD, omem( o_counters + 4 * CNTLOAD ),
+			   insloads[n] );
+	}
+	if (insstores[n] != 0) {
+		alu_o_imm( ALU_ADD, omem( o_counters + 4 * CNTSTORE ),
+			   insstores[n] );
+	}
+	if (taken) alu_o_imm( ALU_ADD, omem( o_counters + 4 * CNTBRANCH ), 1 );
+}
+
+static void giveupcode( int i, WORD which ) {
+	/* give up before instruction i, with which registers changed */
+	writeback( which );
+	count( i, 0 );
+	if (inscyc[i] != 0) alu_r_o( ALU_ADD, CYC, oimm( inscyc[i] ) );
+	mov_m_imm( o_pc, insaddr[i] );
+	mov_r_o( RAX, oimm( 1 ) );
+	patch( jmp(), xit );
+}
+
+static void r0final() {
+	/* leave r[0] as the last instruction did */
+	if (!r0mem) mov_m_imm( 0, r0val );
+}
+
+static void toblock( WORD t, WORD cyc, int taken ) {
+	/* leave the block for static destination t, having used cyc,
+	   by a branch if taken */
+	writeback( dirty );
+	r0final();
+	count( ndone, taken );
+	if (t == 0) { /* BRANCHCHECK, before the block's cycles count */
+		alu_o_r( ALU_ADD, omem( o_morecycles ), CYC );
+		mov_r_o( CYC, oimm( cyc ) );
+	} else {
+		/* go on to t directly, unless the display is due
+		   or the breakpoint is in the block at t */
+		int32_t slot = o_btab + (BHASH( t ) << bshift);
+		BYTE * due;
+		BYTE * miss;
+		BYTE * brk;
+		BYTE * none;
+		alu_r_o( ALU_ADD, CYC, oimm( cyc ) );
+		due = jcc( CC_NS );
+		alu_o_imm( ALU_CMP, omem( slot + offsetof(struct block, start) ), t );
+		miss = jcc( CC_NE );
+		mov_r_o( RDX, omem( o_breakpoint ) );
+		alu_r_o( ALU_SUB, RDX, oimm( t ) );
+		mov_r_o( RCX, omem( slot + offsetof(struct block, end) ) );
+		alu_r_o( ALU_SUB, RCX, oimm( t ) );
+		alu_r_o( ALU_CMP, RDX, oreg( RCX ) );
+		brk = jcc( CC_B );
+		op_rm( 1, 0x8B, RDX, omem( slot + offsetof(struct block, native) ) );
+		test_r64( RDX );
+		none = jcc( CC_E );
+		B( 0xFF ); B( 0xE2 );   /* jmp rdx */
+		patch( due, cp );
+		patch( miss, cp );
+		patch( brk, cp );
+		patch( none, cp );
+	}
+	mov_m_imm( o_pc, t );
+	zero_r( RAX );
+	patch( jmp(), xit );
+}
+
+static void toeax( WORD cyc, int r0eax ) {
+	/* leave the block for the destination in eax, having used cyc */
+	BYTE * zero;
+	BYTE * due;
+	BYTE * miss;
+	BYTE * brk;
+	BYTE * none;
+	BYTE * out;
+	writeback( dirty );
+	count( ndone, 1 );
+	if (r0eax) {
+		mov_o_r( omem( 0 ), RAX );
+	} else {
+		r0final();
+	}
+	test_r( RAX );
+	zero = jcc( CC_E );
+	alu_r_o( ALU_ADD, CYC, oimm( cyc ) );
+	due = jcc( CC_NS );
+
+	/* go on to the block at eax directly, if it is compiled
+	   and the breakpoint is not in it */
+	mov_r_o( RCX, oreg( RAX ) );
+	shift_imm( SH_SHR, RCX, 1 );
+	alu_r_o( ALU_AND, RCX, oimm( (1 << BHASHBITS) - 1 ) );
+	shift_imm( SH_SHL, RCX, bshift );
+	op_sib( 0, 0x3B, RAX, RCX, 0, o_btab + offsetof(struct block, start) );
+	miss = jcc( CC_NE );
+	mov_r_o( RDX, omem( o_breakpoint ) );
+	alu_r_o( ALU_SUB, RDX, oreg( RAX ) );
+	op_sib( 0, 0x8B, R11, RCX, 0, o_btab + offsetof(struct block, end) );
+	alu_r_o( ALU_SUB, R11, oreg( RAX ) );
+	alu_r_o( ALU_CMP, RDX, oreg( R11 ) );
+	brk = jcc( CC_B );
+	op_sib( 1, 0x8B, RDX, RCX, 0, o_btab + offsetof(struct block, native) );
+	test_r64( RDX );
+	none = jcc( CC_E );
+	B( 0xFF ); B( 0xE2 );   /* jmp rdx */
+
+	patch( zero, cp ); /* BRANCHCHECK, before the block's cycles count */
+	alu_o_r( ALU_ADD, omem( o_morecycles ), CYC );
+	mov_r_o( CYC, oimm( cyc ) );
+	out = jmp();
+
+	patch( due, cp );
+	patch( miss, cp );
+	patch( brk, cp );
+	patch( none, cp );
+	patch( out, cp );
+	mov_o_r( omem( o_pc ), RAX );
+	zero_r( RAX );
+	patch( jmp(), xit );
+}
+
+static void checkjump( int i ) {
+	/* give up before instruction i if eax is not a legal fetch */
+	alu_r_o( ALU_CMP, RAX, oimm( jm->memsize ) );
+	giveup( jcc( CC_AE ), i );
+}
+
+/*************************************
+ * condition codes                   *
+ *************************************/
+
+static void preflags( int live ) {
+	/* get ready to capture flags from the next alu operation */
+	if (live) {
+		zero_r( RCX );
+		zero_r( RDX );
+	}
+}
+
+static void postflags( int live, int sub ) {
+	/* put the flags from the last alu operation in psw,
+	   as N Z V C, where for sub, C means no borrow */
+	if (!live) return;
+	setcc( sub ? CC_AE : CC_B, RCX );
+	setcc( CC_O, RDX );
+	lea_rs( RCX, RCX, RDX, 1 );
+	setcc( CC_S, RDX );
+	lea_rs( RCX, RCX, RDX, 3 );
+	setcc( CC_E, RDX );
+	lea_rs( RCX, RCX, RDX, 2 );
+	alu_r_o( ALU_AND, PSW, oimm( ~(CC | CBITS) ) );
+	alu_r_o( ALU_OR, PSW, oreg( RCX ) );
+}
+
+static void setccflags( int i ) {
+	/* SETCC(eax) */
+	preflags( pswlive[i] );
+	test_r( RAX );
+	postflags( pswlive[i], 0 );
+	if (carlive[i]) mov_m_imm( o_carries, 0 );
+}
+
+static void addcc( int i, int d, struct opnd x, struct opnd y, int sub ) {
+	/* r[d] = x + y or x - y, ADDTOCC style */
+	int p = pswlive[i];
+	int c = carlive[i];
+	if (c) { /* carries = x ^ y ^ sum, or with ~y for sub */
+		if (x.kind == OIMM) {
+			mov_m_imm( o_carries, x.val );
+		} else {
+			mov_r_o( RDX, x );
+			mov_o_r( omem( o_carries ), RDX );
+		}
+	}
+	preflags( p );
+	mov_r_o( RAX, x );
+	alu_r_o( sub ? ALU_SUB : ALU_ADD, RAX, y );
+	postflags( p, sub );
+	if (c) {
+		alu_o_r( ALU_XOR, omem( o_carries ), RAX );
+		if (y.kind == OIMM) {
+			alu_o_imm( ALU_XOR, omem( o_carries ), y.val );
+		} else {
+			mov_r_o( RDX, y );
+			alu_o_r( ALU_XOR, omem( o_carries ), RDX );
+		}
+		if (sub) not_o( omem( o_carries ) );
+	}
+	dst( d, RAX );
+}
+
+static void setnulls( int i ) {
+	/* SETNULLS(eax), C set if any byte is zero */
+	if (!pswlive[i]) return;
+	lea_rd( RDX, RAX, -0x01010101 );
+	mov_r_o( RCX, oreg( RAX ) );
+	not_o( oreg( RCX ) );
+	alu_r_o( ALU_AND, RDX, oreg( RCX ) );
+	alu_r_o( ALU_AND, RDX, oimm( 0x80808080UL ) );
+	alu_r_o( ALU_ADD, RDX, oimm( 0xFFFFFFFFUL ) ); /* carry if nonzero */
+	alu_r_o( ALU_ADC, PSW, oimm( 0 ) );            /* C was zero */
+}
+
+/*************************************
+ * memory reference                  *
+ *************************************/
+
+static void eaddr( struct decoded * d, WORD base ) {
+	/* eax = (imm + r[X], with r[0] = base) & ~3, for long forms;
+	   eax = r[X] & ~3, with r[0] = base, for short */
+	if (d->s2 == 0) {
+		mov_r_o( RAX, oimm( (base + ((d->len == 4) ? d->imm : 0))
+				  & 0xFFFFFFFCUL ) );
+		return;
+	}
+	if (d->len == 4) {
+		mov_r_o( RAX, oimm( d->imm ) );
+		alu_r_o( ALU_ADD, RAX, loc[d->s2] );
+	} else {
+		mov_r_o( RAX, loc[d->s2] );
+	}
+	alu_r_o( ALU_AND, RAX, oimm( 0xFFFFFFFCUL ) );
+}
+
+static void load( int i ) {
+	/* eax = m[eax], giving up unless eax is in memory */
+	alu_r_o( ALU_CMP, RAX, oimm( jm->memsize ) );
+	giveup( jcc( CC_AE ), i );
+	op_far( 0, 0x8B, RAX, RAX, jm->m );
+}
+
+static void store( int i, struct opnd v ) {
+	/* m[eax] = v, giving up unless eax is in RAM outside of
+	   predecoded code and not snooped by LOADL */
+	lea_rd( RCX, RAX, -(int32_t)jm->romsize );
+	alu_r_o( ALU_CMP, RCX, oimm( jm->memsize - jm->romsize ) );
+	giveup( jcc( CC_AE ), i );
+	alu_r_o( ALU_CMP, RAX, omem( o_snoop ) );
+	giveup( jcc( CC_E ), i );
+	mov_r_o( RCX, oreg( RAX ) );
+	shift_imm( SH_SHR, RCX, DPAGEBITS );
+	op_far( 0, 0x80, 7, RCX, jm->dpage ); B( 0 ); /* cmp byte, 0 */
+	giveup( jcc( CC_NE ), i );
+	if (v.kind == OIMM) {
+		op_far( 0, 0xC7, 0, RAX, jm->m ); d32( v.val );
+	} else {
+		if (v.kind == OMEM) {
+			mov_r_o( RDX, v );
+			v = oreg( RDX );
+		}
+		op_far( 0, 0x89, v.reg, RAX, jm->m );
+	}
+}
+
+/*************************************
+ * the instructions                  *
+ *************************************/
+
+static int compile( int i ) {
+	/* compile instruction i, return nonzero if it ended the block */
+	struct decoded * d = ins[i];
+	WORD a = insaddr[i];
+	WORD p2 = a + 2;
+	WORD p4 = a + 4;
+	WORD cyc = inscyc[i + 1];  /* the block's cycles up to i */
+
+	r0val = 0;
+	r0mem = 0;
+	ndone = i + 1;
+	switch (d->op) {
+
+	case 0xFF: /* MOVE */
+		r0val = p2;
+		mov_r_o( RAX, src( d->s2 ) );
+		dst( d->dst, RAX );
+		break;
+
+	case 0xFE: /* MOVECC */
+		r0val = p2;
+		mov_r_o( RAX, src( d->s2 ) );
+		setccflags( i );
+		dst( d->dst, RAX );
+		break;
+
+	case 0xFD: /* LOADS */
+	case 0xF5: /* LOAD */
+		r0val = (d->len == 4) ? p4 : p2;
+		eaddr( d, r0val );
+		load( i );
+		if (d->dst != 0) {
+			dst( d->dst, RAX );
+			break;
+		}
+		checkjump( i );
+		toeax( cyc + 1, 1 );
+		return 1;
+
+	case 0xFC: /* LOADSCC */
+	case 0xF4: /* LOADCC */
+		r0val = (d->len == 4) ? p4 : p2;
+		eaddr( d, r0val );
+		load( i );
+		setccflags( i );
+		setnulls( i );
+		dst( d->dst, RAX );
+		break;
+
+	case 0xFB: /* JSRS */
+	case 0xF3: /* JSR */
+		r0val = (d->len == 4) ? p4 : p2;
+		if (d->s2 == 0) {
+			WORD t = r0val + ((d->len == 4) ? d->imm : 0);
+			if (d->dst != 0) {
+				mov_r_o( RAX, oimm( r0val ) );
+				dst( d->dst, RAX );
+			}
+			toblock( t, cyc + 1, 1 );
+			return 1;
+		}
+		if (d->len == 4) {
+			mov_r_o( RAX, oimm( d->imm ) );
+			alu_r_o( ALU_ADD, RAX, loc[d->s2] );
+		} else {
+			mov_r_o( RAX, loc[d->s2] );
+		}
+		checkjump( i );
+		if (d->dst != 0) {
+			mov_r_o( RCX, oimm( r0val ) );
+			dst( d->dst, RCX );
+		}
+		toeax( cyc + 1, 0 );
+		return 1;
+
+	case 0xFA: /* STORES */
+	case 0xF2: /* STORE */
+		eaddr( d, (d->len == 4) ? p4 : p2 );
+		store( i, src( d->dst ) ); /* r[0] is zero again by now */
+		break;
+
+	case 0xF7: /* LEA */
+		r0val = p4;
+		if (d->s2 == 0) {
+			mov_r_o( RAX, oimm( d->imm + p4 ) );
+		} else {
+			mov_r_o( RAX, oimm( d->imm ) );
+			alu_r_o( ALU_ADD, RAX, loc[d->s2] );
+		}
+		dst( d->dst, RAX );
+		break;
+
+	case 0xF6: /* LEACC */
+		r0val = p4;
+		addcc( i, d->dst, oimm( d->imm ), src( d->s2 ), 0 );
+		break;
+
+	case 0xE0: /* LIL */
+		if (d->dst == 0) {
+			r0val = d->imm;
+			toblock( d->imm, cyc + 1, 1 );
+			return 1;
+		}
+		mov_r_o( RAX, oimm( d->imm ) );
+		dst( d->dst, RAX );
+		break;
+
+	case 0xD0: /* LIS */
+		mov_r_o( RAX, oimm( d->imm ) );
+		dst( d->dst, RAX );
+		break;
+
+	case 0xC0: /* ORIS */
+		mov_r_o( RAX, loc[d->dst] );
+		shift_imm( SH_SHL, RAX, 8 );
+		alu_r_o( ALU_OR, RAX, oimm( d->imm ) );
+		dst( d->dst, RAX );
+		break;
+
+	case 0xA0: /* ADDSL */
+		{
+			int k = ((d->s2 - 1) & 0xF) + 1;
+			mov_r_o( RAX, loc[d->dst] );
+			if (pswlive[i]) { /* bits shifted out set C */
+				mov_r_o( R11, oreg( RAX ) );
+				shift_imm( SH_SHR, R11, 32 - k );
+			}
+			shift_imm( SH_SHL, RAX, k );
+			addcc( i, d->dst, oreg( RAX ), src( d->s1 ), 0 );
+			if (pswlive[i]) {
+				zero_r( RDX );
+				neg_r( R11 );
+				setcc( CC_B, RDX );
+				alu_r_o( ALU_OR, PSW, oreg( RDX ) );
+			}
+		}
+		break;
+
+	case 0x90: /* ADDSR */
+		{
+			int k = ((d->s2 - 1) & 0xF) + 1;
+			WORD mask = 0x7FFFFFFFUL >> (k - 1);
+			mov_r_o( RAX, src( d->dst ) );
+			zero_r( RCX );
+			alu_r_o( ALU_ADD, RAX, src( d->s1 ) );
+			setcc( CC_L, RCX );  /* true sign of the sum */
+			mov_r_o( RDX, oreg( RAX ) );
+			shift_imm( SH_SHR, RAX, k );
+			neg_r( RCX );
+			alu_r_o( ALU_AND, RCX, oimm( ~mask ) );
+			alu_r_o( ALU_OR, RAX, oreg( RCX ) );
+			if (pswlive[i]) {
+				/* V if any bit shifted out, C if the last did */
+				mov_r_o( R11, oreg( RDX ) );
+				alu_r_o( ALU_AND, R11, oimm( (1UL << k) - 1 ) );
+				shift_imm( SH_SHR, RDX, k - 1 );
+				alu_r_o( ALU_AND, RDX, oimm( 1 ) );
+				zero_r( RCX );
+				neg_r( R11 );
+				setcc( CC_B, RCX );
+				lea_rs( RDX, RDX, RCX, 1 );
+				test_r( RAX );
+				setcc( CC_S, RCX );
+				lea_rs( RDX, RDX, RCX, 3 );
+				setcc( CC_E, RCX );
+				lea_rs( RDX, RDX, RCX, 2 );
+				alu_r_o( ALU_AND, PSW, oimm( ~(CC | CBITS) ) );
+				alu_r_o( ALU_OR, PSW, oreg( RDX ) );
+			}
+			if (carlive[i]) mov_m_imm( o_carries, 0 );
+			dst( d->dst, RAX );
+		}
+		break;
+
+	case 0x70: /* STUFFB */
+	case 0x60: /* STUFFH */
+		{
+			WORD width = (d->op == 0x70) ? 0xFF : 0xFFFF;
+			mov_r_o( RCX, src( d->s2 ) );
+			alu_r_o( ALU_AND, RCX, oimm( (d->op == 0x70) ? 3 : 2 ) );
+			shift_imm( SH_SHL, RCX, 3 );
+			mov_r_o( RDX, oimm( width ) );
+			shift_cl( SH_SHL, RDX );
+			not_o( oreg( RDX ) );
+			mov_r_o( RAX, loc[d->dst] );
+			alu_r_o( ALU_AND, RAX, oreg( RDX ) );
+			mov_r_o( RDX, src( d->s1 ) );
+			alu_r_o( ALU_AND, RDX, oimm( width ) );
+			shift_cl( SH_SHL, RDX );
+			alu_r_o( ALU_OR, RAX, oreg( RDX ) );
+			dst( d->dst, RAX );
+		}
+		break;
+
+	case 0x50: /* EXTB */
+	case 0x40: /* EXTH */
+		mov_r_o( RCX, src( d->s2 ) );
+		alu_r_o( ALU_AND, RCX, oimm( (d->op == 0x50) ? 3 : 2 ) );
+		shift_imm( SH_SHL, RCX, 3 );
+		mov_r_o( RAX, loc[d->s1] );
+		shift_cl( SH_SHR, RAX );
+		alu_r_o( ALU_AND, RAX, oimm( (d->op == 0x50) ? 0xFF : 0xFFFF ) );
+		setccflags( i );
+		dst( d->dst, RAX );
+		break;
+
+	case 0x30: /* ADD */
+		addcc( i, d->dst, loc[d->s1], loc[d->s2], 0 );
+		break;
+
+	case 0x20: /* SUB */
+		addcc( i, d->dst, src( d->s1 ), loc[d->s2], 1 );
+		break;
+
+	case 0x1C: /* ADDSI */
+		addcc( i, d->dst, loc[d->dst], oimm( d->imm ), 0 );
+		break;
+
+	case 0x1B: /* AND */
+	case 0x1A: /* OR */
+	case 0x19: /* EQU */
+		mov_r_o( RAX, loc[d->dst] );
+		if (d->op == 0x1B) {
+			alu_r_o( ALU_AND, RAX, loc[d->s2] );
+		} else if (d->op == 0x1A) {
+			alu_r_o( ALU_OR, RAX, loc[d->s2] );
+		} else {
+			alu_r_o( ALU_XOR, RAX, src( d->s2 ) );
+			not_o( oreg( RAX ) );
+		}
+		setccflags( i );
+		dst( d->dst, RAX );
+		break;
+
+	case 0x00: /* Bcc */
+		if (d->dst == 0) { /* BR */
+			toblock( p2 + d->imm, cyc + 1, 1 );
+		} else {
+			BYTE * taken;
+			mov_r_o( RAX, oreg( PSW ) );
+			alu_r_o( ALU_AND, RAX, oimm( CC ) );
+			op_sib( 0, 0xF7, 0, RAX, 2, o_cctab ); /* test */
+			d32( 1 << d->dst );
+			taken = jcc( CC_NE );
+			toblock( p2, cyc, 0 );
+			patch( taken, cp );
+			toblock( p2 + d->imm, cyc + 1, 1 );
+		}
+		return 1;
+	}
+	return 0;
+}
+
+/*************
+ * Interface *
+ *************/
+
+void jit_compile( struct hawk_machine * hm, struct block * b ) {
+	/* compile b, setting b->native, unless host code can't start it */
+	struct uop * u = b->u;
+	WORD a = b->start;
+	BYTE * start;
+	int i;
+	int ended = 0;
+
+	jt = hm->jit;
+	for (nins = 0; u[nins].d.op != OP_END; nins++) {
+		ins[nins] = &u[nins].d;
+		insaddr[nins] = a;
+		inscyc[nins] = u[nins].cyc;
+		if (!supported( ins[nins], a )) break;
+		a += ins[nins]->len;
+	}
+	if (nins == 0) return;
+	if (u[nins].d.op == OP_END) {
+		insaddr[nins] = a;
+		inscyc[nins] = u[nins].d.imm;
+	}
+	insloads[0] = insstores[0] = 0;
+	for (i = 0; i < nins; i++) {
+		int op = ins[i]->op;
+		insloads[i + 1] = insloads[i]
+			+ ((op == 0xFD) || (op == 0xFC) || (op == 0xF5) || (op == 0xF4));
+		insstores[i + 1] = insstores[i] + ((op == 0xFA) || (op == 0xF2));
+	}
+
+	if (cp > code + CODESIZE - BLOCKCODE) { /* forget all host code */
+		for (i = 0; i < (1 << BHASHBITS); i++) hm->btab[i].native = NULL;
+		cp = blockcode;
+	}
+	if (!unlock( cp, 1 )) return; /* leave b to the interpreter */
+
+	liveness();
+	allocate();
+	dirty = 0;
+	ngiveups = 0;
+
+	start = cp;
+	for (i = 1; i < 16; i++) {
+		if (inreg & (1 << i)) mov_r_o( loc[i].reg, omem( i * 4 ) );
+	}
+	for (i = 0; i < nins; i++) {
+		ended = compile( i );
+		if (ended) break;
+	}
+	if (!ended) {
+		if (u[nins].d.op == OP_END) { /* ran off the end, no branch */
+			ndone = nins;
+			toblock( insaddr[nins], inscyc[nins], 0 );
+		} else { /* the interpreter must do the next one */
+			giveupcode( nins, dirty );
+		}
+	}
+	for (i = 0; i < ngiveups; i++) {
+		patch( giveups[i].at, cp );
+		giveupcode( giveups[i].i, giveups[i].dirty );
+	}
+	if (!unlock( start, 0 )) { /* other blocks share these pages */
+		fputs( progname, stderr );
+		fputs( ": cannot make host code executable\n", stderr );
+		exit( EXIT_FAILURE ); /* error */
+	}
+	b->native = start;
+}
+
+int jit_run( struct hawk_machine * hm, struct block * b ) {
+	/* run host code, starting with b */
+	jt = hm->jit;
+	return enter( b->native );
+}
+
+void jit_free( struct hawk_machine * hm ) {
+	/* give back what jit_init made for hm */
+	if (hm->jit == NULL) return;
+	jt = hm->jit;
+	if (code != NULL) munmap( code, CODESIZE );
+	free( hm->jit );
+	hm->jit = NULL;
+}
+
+#endif
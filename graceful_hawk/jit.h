@@ -0,0 +1,44 @@
+/* File: jit.h
+   Date: Oct. 16, 2026
+   Language: C (UNIX)
+   Purpose: Hawk Emulator, interface to the x86-64 block compiler
+*/
+
+/* assumes prior inclusion of <stdint.h>, "bus.h", "decode.h", "block.h" */
+
+/***************************
+ * native code for blocks  *
+ ***************************/
+
+/* the block engine counts entries to each block; when a block has been
+   entered JIT_HOT times, it is compiled to host code and from then on
+   the host code runs in its place.  Compiled blocks jump directly to
+   each other until the display is due, control reaches PC = 0 or the
+   next block holds the breakpoint; the block engine never runs host
+   code for a block with the breakpoint inside it.
+
+   host code gives up before any instruction it cannot finish on its
+   own (traps, I/O, stores into ROM or into predecoded code, and
+   instructions it does not know); the state is then exactly as it
+   was before that instruction, and the interpreter must run it.
+*/
+#define JIT_HOT 32
+
+/* each machine has host code of its own, in a code buffer of its own,
+   held in hm->jit, see machine.h */
+
+int jit_init( struct hawk_machine * hm, unsigned int * cctab );
+/* set up the compiler for the machine hm, given the CPU's private state
+   it must reach, unless it already was; returns zero if host code cannot
+   be run for hm, so the JIT is unusable */
+
+void jit_compile( struct hawk_machine * hm, struct block * b );
+/* compile b, a block of hm, setting b->native, unless its first
+   instruction is one that host code cannot do */
+
+int jit_run( struct hawk_machine * hm, struct block * b );
+/* run host code of hm starting with b, whose b->native must be set;
+   returns nonzero if the interpreter must run the instruction at pc */
+
+void jit_free( struct hawk_machine * hm );
+/* give back what jit_init made for hm */
@@ -0,0 +1,334 @@
+/* File: jobs.c
+   Date: Oct. 16, 2026
+   Language: C (UNIX)
+   Purpose: Hawk Emulator, parallel batch runner;
+		runs the jobs of a manifest in batch mode, each in a child
+		process of its own, several at a time, then reports the
+		final state of each.
+*/
+
+#include <errno.h>
+#include <inttypes.h>
+#include <poll.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include "bus.h"
+#include "powerup.h"
+#include "jobs.h"
+
+/*****************
+ * the manifest  *
+ *****************/
+
+struct job {
+	char * name;
+	WORD cycles;            /* the cycle limit, 0 for none */
+	char * expected;        /* the expected display file, or NULL */
+	char ** files;          /* the object files, NULL terminated */
+
+	pid_t pid;              /* the child running it, 0 if none */
+	int fd;                 /* the pipe from its stdout and stderr */
+	struct timespec start;  /* when it started */
+	double seconds;         /* how long it ran */
+	char * out;             /* what it put on stdout and stderr */
+	size_t len;             /* how much of that there is so far */
+	int status;             /* how it exited, see waitpid */
+};
+
+static struct job * jobs = NULL;
+static int njobs = 0;
+
+static void fail( const char * name, const char * why ) {
+	fputs( progname, stderr );
+	fputs( " -J ", stderr );
+	fputs( name, stderr );
+	fputs( why, stderr );
+	exit( EXIT_FAILURE ); /* error */
+}
+
+static void * grow( void * p, size_t size ) {
+	/* realloc, or exit */
+	p = realloc( p, size );
+	if (p == NULL) fail( "", ": out of memory\n" );
+	return p;
+}
+
+static void readmanifest( const char * manifest ) {
+	/* fill jobs from the file manifest */
+	FILE * f = fopen( manifest, "r" );
+	char * line = NULL;
+	size_t size = 0;
+
+	if (f == NULL) fail( manifest, ": cannot open manifest\n" );
+	while (getline( &line, &size, f ) >= 0) {
+		char * words[4];
+		char * e;
+		char * w = strtok( line, " \t\r\n" );
+		struct job * j;
+		int n = 0;
+
+		if ((w == NULL) || (*w == '#')) continue;
+		while ((w != NULL) && (n < 4)) {
+			words[n++] = w;
+			if (n < 4) w = strtok( NULL, " \t\r\n" );
+		}
+		if (n < 4) fail( manifest, ": job without object files\n" );
+
+		jobs = grow( jobs, sizeof( struct job ) * (njobs + 1) );
+		j = &jobs[njobs++];
+		memset( j, 0, sizeof( struct job ) );
+		j->name = words[0];
+		j->cycles = (WORD)strtoull( words[1], &e, 0 );
+		if ((e == words[1]) || (*e != '\0')) {
+			fail( manifest, ": bad cycle limit\n" );
+		}
+		j->expected = strcmp( words[2], "-" ) ? words[2] : NULL;
+		n = 0;
+		do {
+			j->files = grow( j->files, sizeof( char * ) * (n + 2) );
+			j->files[n++] = w;
+			w = strtok( NULL, " \t\r\n" );
+		} while (w != NULL);
+		j->files[n] = NULL;
+
+		line = NULL; /* the job keeps pieces of this line */
+		size = 0;
+	}
+	fclose( f );
+	if (njobs == 0) fail( manifest, ": no jobs\n" );
+}
+
+/*****************
+ * running jobs  *
+ *****************/
+
+static pid_t start( struct job * j ) {
+	/* start j, returns 0 in the child */
+	int p[2];
+	pid_t pid;
+
+	fflush( stdout );
+	fflush( stderr );
+	if (pipe( p ) != 0) fail( j->name, ": cannot make a pipe\n" );
+	clock_gettime( CLOCK_MONOTONIC, &j->start );
+	pid = fork();
+	if (pid < 0) fail( j->name, ": cannot fork\n" );
+	if (pid == 0) {
+		dup2( p[1], 1 );
+		dup2( p[1], 2 );
+		close( p[0] );
+		close( p[1] );
+		return 0;
+	}
+	close( p[1] );
+	j->pid = pid;
+	j->fd = p[0];
+	j->out = grow( NULL, 4096 );
+	j->len = 0;
+	return pid;
+}
+
+static int collect( struct job * j ) {
+	/* read what j has put on its pipe so far, as it runs, so that a
+	   job with more to say than the pipe holds never waits on it;
+	   returns zero once the job has closed its end */
+	ssize_t n;
+
+	j->out = grow( j->out, j->len + 4096 );
+	n = read( j->fd, j->out + j->len, 4095 );
+	if (n > 0) j->len += n;
+	return (n > 0) || ((n < 0) && (errno == EINTR));
+}
+
+static void finish( struct job * j ) {
+	/* j has closed its pipe, wait for it to exit */
+	struct timespec now;
+	int status;
+
+	while ((waitpid( j->pid, &status, 0 ) < 0) && (errno == EINTR)) {
+		/* try again */
+	}
+	clock_gettime( CLOCK_MONOTONIC, &now );
+	j->seconds = (double)(now.tv_sec - j->start.tv_sec)
+		   + (double)(now.tv_nsec - j->start.tv_nsec) / 1e9;
+	j->status = status;
+	j->out[j->len] = '\0';
+	close( j->fd );
+	j->pid = 0;
+}
+
+/*****************
+ * results       *
+ *****************/
+
+static char * slurp( const char * name ) {
+	/* the contents of the file name, or NULL */
+	FILE * f = fopen( name, "r" );
+	char * s = NULL;
+	size_t len = 0;
+	size_t n;
+
+	if (f == NULL) return NULL;
+	do {
+		s = grow( s, len + 4097 );
+		n = fread( s + len, 1, 4096, f );
+		len += n;
+	} while (n > 0);
+	s[len] = '\0';
+	fclose( f );
+	return s;
+}
+
+static size_t trimmed( const char * s, size_t len ) {
+	/* the length of s[0 .. len-1] without trailing white space */
+	while ((len > 0) && ((s[len - 1] == '\n') || (s[len - 1] == ' '))) {
+		len--;
+	}
+	return len;
+}
+
+static int report( struct job * j ) {
+	/* put the result line for j to stdout, return nonzero if passed */
+	WORD regs[16] = { 0 };    /* PC, R1 to RF */
+	WORD psw = 0;
+	uint64_t cycles = 0, instructions = 0;
+	const char * result;
+	char * stop = strstr( j->out, "stop:" );
+	char * w;
+	int i;
+
+	if ((stop == NULL) || ((stop != j->out) && (stop[-1] != '\n'))
+	||  !WIFEXITED( j->status )) {
+		/* it never got to the report, say why if it said */
+		char * nl = strchr( j->out, '\n' );
+		if (nl != NULL) *nl = '\0';
+		if (j->out[0] == '\0') {
+			j->out = WIFSIGNALED( j->status ) ? "killed" : "-";
+		}
+		printf( "%s\terror\t%s", j->name, j->out );
+		for (i = 0; i < 19; i++) fputs( "\t-", stdout );
+		printf( "\t%.3f\n", j->seconds );
+		return 0;
+	}
+
+	/* the display is all before the blank line before stop */
+	*stop = '\0';
+	stop += 5;
+	result = "pass";
+	if (j->expected != NULL) {
+		char * want = slurp( j->expected );
+		if ((want == NULL)
+		||  (trimmed( want, strlen( want ) )
+		     != trimmed( j->out, strlen( j->out ) ))
+		||  strncmp( want, j->out, trimmed( want, strlen( want ) ) )) {
+			result = "fail";
+		}
+		free( want );
+	}
+
+	/* pick the values out of the rest of the report */
+	while (*stop == ' ') stop++;
+	w = strchr( stop, '\n' );
+	if (w == NULL) {
+		w = stop + strlen( stop );
+	} else {
+		*w++ = '\0';
+	}
+	for (w = strtok( w, " \n" ); w != NULL; w = strtok( NULL, " \n" )) {
+		char * v = strtok( NULL, " \n" );
+		if (v == NULL) break;
+		if (!strcmp( w, "PC:" )) {
+			regs[0] = (WORD)strtoul( v, NULL, 16 );
+		} else if (!strcmp( w, "PSW:" )) {
+			psw = (WORD)strtoul( v, NULL, 16 );
+		} else if ((w[0] == 'R') && (w[2] == ':') && (w[3] == '\0')) {
+			regs[strtoul( w + 1, NULL, 16 ) & 0xF] =
+				(WORD)strtoul( v, NULL, 16 );
+		} else if (!strcmp( w, "cycles:" )) {
+			cycles = strtoull( v, NULL, 10 );
+		} else if (!strcmp( w, "instructions:" )) {
+			instructions = strtoull( v, NULL, 10 );
+		}
+	}
+	if (strstr( stop, "limit" ) != NULL) result = "limit";
+
+	printf( "%s\t%s\t%s\t%08"PRIX32"\t%08"PRIX32,
+		j->name, result, stop, regs[0], psw );
+	for (i = 1; i < 16; i++) printf( "\t%08"PRIX32, regs[i] );
+	printf( "\t%"PRIu64"\t%"PRIu64"\t%.3f\n",
+		cycles, instructions, j->seconds );
+	return result[0] == 'p';
+}
+
+/*************
+ * Interface *
+ *************/
+
+void jobs_run( struct hawk_machine * hm, const char * manifest,
+	       int workers ) {
+	/* run the jobs in manifest, returning only in their children */
+	int next = 0;    /* the next job to start */
+	int running = 0; /* how many have started and not finished */
+	int passed = 0;
+	struct pollfd * fds;
+	struct job ** fdjob; /* the job for each entry of fds */
+	int i;
+
+	readmanifest( manifest );
+	if (workers <= 0) workers = (int)sysconf( _SC_NPROCESSORS_ONLN );
+	if (workers <= 0) workers = 1;
+	fds = grow( NULL, sizeof( struct pollfd ) * workers );
+	fdjob = grow( NULL, sizeof( struct job * ) * workers );
+
+	while ((next < njobs) || (running > 0)) {
+		int n = 0;
+
+		while ((running < workers) && (next < njobs)) {
+			struct job * j = &jobs[next++];
+			if (start( j ) == 0) { /* this is the job */
+				char ** f;
+				batch = 1;
+				if (j->cycles != 0) cyclelimit = j->cycles;
+				for (f = j->files; *f != NULL; f++) {
+					powerup_load( hm, *f );
+				}
+				return;
+			}
+			running++;
+		}
+
+		/* drain the pipes of the running jobs as they fill; a job
+		   is done when it closes its pipe */
+		for (i = 0; i < next; i++) {
+			if (jobs[i].pid != 0) {
+				fds[n].fd = jobs[i].fd;
+				fds[n].events = POLLIN;
+				fdjob[n++] = &jobs[i];
+			}
+		}
+		if (poll( fds, n, -1 ) < 0) {
+			if (errno == EINTR) continue;
+			fail( "", ": cannot poll the jobs\n" );
+		}
+		for (i = 0; i < n; i++) {
+			if (fds[i].revents == 0) continue;
+			if (!collect( fdjob[i] )) {
+				finish( fdjob[i] );
+				running--;
+			}
+		}
+	}
+	free( fds );
+	free( fdjob );
+
+	fputs( "job\tresult\tstop\tpc\tpsw", stdout );
+	for (i = 1; i < 16; i++) printf( "\tR%X", i );
+	fputs( "\tcycles\tinstructions\tseconds\n", stdout );
+	for (i = 0; i < njobs; i++) passed += report( &jobs[i] );
+	exit( (passed == njobs) ? EXIT_SUCCESS : EXIT_FAILURE );
+}
@@ -0,0 +1,39 @@
+/* File: jobs.h
+   Date: Oct. 16, 2026
+   Language: C (UNIX)
+   Purpose: Hawk Emulator, interface to the parallel batch runner
+*/
+
+/* assumes prior inclusion of <stdint.h> and "bus.h" */
+
+/*******************
+ * batches of jobs *
+ *******************/
+
+/* -J manifest runs each job in the manifest in batch mode, see batch.h,
+   in a child process of its own, with up to -j workers at a time, by
+   default one per host CPU.  Each line of the manifest is one job:
+
+	name  cycles  expected  object files ...
+
+   where cycles is the job's cycle limit, as for -C, or 0 to keep the
+   limit given by -C, if any, and expected names a file holding the
+   display the job should leave, or is - if any display will do.  Blank
+   lines and lines starting with # are ignored.  Options other than -J
+   and -j apply to every job.
+
+   once every job is done, one tab separated line per job, in manifest
+   order, is put to stdout, under a header line:
+
+	job  result  stop  pc  psw  R1 ... RF  cycles  instructions  seconds
+
+   where result is pass, fail if the display was not as expected, limit
+   if the job ran out of cycles or instructions, or error if it did not
+   run to the end, and seconds is the wall clock time of the job.  The
+   exit status is EXIT_FAILURE unless every job passed.
+*/
+
+void jobs_run( struct hawk_machine * hm, const char * manifest,
+	       int workers );
+/* run the jobs in manifest, called from powerup; returns only in the
+   child process for a job, with it loaded into hm, and otherwise exits */
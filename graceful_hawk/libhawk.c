@@ -0,0 +1,341 @@
+/* File: libhawk.c
+   Date: Oct. 16, 2026
+   Language: C (UNIX)
+   Purpose: Hawk Emulator, the embeddable emulator library;
+		takes the place of the console, so that a program of
+		its own can create, load and run Hawk machines.
+*/
+
+#include <inttypes.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <sys/mman.h>
+#include "bus.h"
+#include "decode.h"
+#include "block.h"
+#include "mmu.h"
+#include "machine.h"
+#include "jit.h"
+#include "console.h"
+#include "powerup.h"
+#include "libhawk.h"
+
+/*****************
+ * the machines  *
+ *****************/
+
+/* each machine is embedded in one of these, holding what the library
+   keeps for it; console() and the devices find it from the machine
+   they are handed, see machine.h */
+#define MAXBREAKS 16
+
+struct embedded {
+	struct hawk_machine hm;  /* first, so that hm is the embedding */
+
+	hawk_read_fn * read;     /* the devices, see hawk_devices */
+	hawk_write_fn * write;
+	void * ctx;
+
+	WORD breaks[ MAXBREAKS ]; /* breakpoints beyond hm.breakpoint */
+	int nbreaks;
+
+	/* the current run, see hawk_run */
+	int started;             /* nonzero once console() has been called */
+	int halted;              /* nonzero once hawk_stop was called */
+	WORD startcycles;        /* the counts when it started */
+	uint64_t startinstr;
+	WORD cyclelimit;         /* its limits, 0 for none */
+	uint64_t instrlimit;
+};
+
+#define EMBEDDING(h) ((struct embedded *)(h))
+
+/* nonzero once the process-wide settings in bus.h are made, so that
+   creating a machine never touches them while others run */
+static int shared = 0;
+
+/* most cycles run between checks of the limits, as in batch.c */
+#define SLICE 0x100000
+
+/********************
+ * console function *
+ ********************/
+
+/* there is no front panel; console() is called whenever the console
+   would have been, and stops the machine it is handed or gives it
+   another slice of cycles */
+
+void console_startup( struct hawk_machine * hm ) {
+	/* nothing to start */
+}
+
+int console_running() {
+	/* machines always run while hawk_run is running them */
+	return 1;
+}
+
+void change_display( int mode ) {
+	/* there is no display to change */
+}
+
+static int isbreak( struct embedded * e ) {
+	/* is pc at a breakpoint? */
+	int i;
+	if (e->hm.pc == e->hm.breakpoint) return 1;
+	for (i = 0; i < e->nbreaks; i++) {
+		if (e->hm.pc == e->breaks[i]) return 1;
+	}
+	return 0;
+}
+
+void console( struct hawk_machine * hm ) {
+	/* called whenever the console would have been; the first call of
+	   each run lets the first instruction go, later calls stop it or
+	   allow another slice of cycles */
+	struct embedded * e = EMBEDDING( hm );
+	WORD used = hm->cycles + hm->morecycles - e->startcycles;
+	uint64_t ran = hm->instructions - e->startinstr;
+	WORD slice = SLICE;
+
+	if (!e->started) {
+		e->started = 1;
+	} else if (e->halted) {
+		hm->stop = HAWK_STOP_HOST;
+	} else if (hm->pc == 0) {
+		hm->stop = HAWK_STOP_ZERO;
+	} else if (isbreak( e )) {
+		hm->stop = HAWK_STOP_BREAK;
+	} else if ((e->cyclelimit != 0) && (used >= e->cyclelimit)) {
+		hm->stop = HAWK_STOP_CYCLES;
+	} else if ((e->instrlimit != 0) && (ran >= e->instrlimit)) {
+		hm->stop = HAWK_STOP_INSTR;
+	}
+	if (hm->stop) return;
+
+	if ((e->cyclelimit != 0) && ((e->cyclelimit - used) < slice)) {
+		slice = e->cyclelimit - used;
+	}
+	if (e->instrlimit != 0) {
+		/* in s cycles, at most 2s instructions run, since only a
+		   short instruction in the low half of a word takes no
+		   cycle; with none left to spare, go one at a time */
+		uint64_t left = e->instrlimit - ran;
+		if ((left / 2) < slice) slice = (WORD)(left / 2);
+	}
+	if (e->nbreaks > 0) slice = 0; /* check them after every one */
+	hm->morecycles += hm->cycles + slice;
+	hm->cycles = -slice; /* next call when it's positive */
+}
+
+/*****************************
+ * memory mapped I/O devices *
+ *****************************/
+
+/* each goes to the functions given to hawk_devices */
+
+void dispwrite( struct hawk_machine * hm, WORD addr, WORD val ) {
+	struct embedded * e = EMBEDDING( hm );
+	if (e->write != NULL) e->write( e->ctx, hm, addr, val );
+}
+
+WORD dispread( struct hawk_machine * hm, WORD addr ) {
+	struct embedded * e = EMBEDDING( hm );
+	if (e->read == NULL) return 0;
+	return e->read( e->ctx, hm, addr );
+}
+
+void kbdwrite( struct hawk_machine * hm, WORD addr, WORD val ) {
+	dispwrite( hm, addr, val );
+}
+
+WORD kbdread( struct hawk_machine * hm, WORD addr ) {
+	return dispread( hm, addr );
+}
+
+WORD kbd_state() {
+	/* the keyboard belongs to the devices, so there is nothing here
+	   for snapshots */
+	return 0;
+}
+
+void kbd_setstate( WORD state ) {
+}
+
+/*************
+ * Interface *
+ *************/
+
+struct hawk_machine * hawk_create( uint32_t memsize, uint32_t romsize ) {
+	/* a new machine, powered up */
+	struct embedded * e;
+	struct hawk_machine * hm;
+
+	if (memsize == 0) memsize = MAXMEM;
+	if (romsize == 0) romsize = MAXROM;
+	if ((memsize & 0xFFFF) || (memsize >= IOSPACE)
+	||  (romsize & 0xFFFF) || (romsize > memsize)) return NULL;
+	e = calloc( 1, sizeof( struct embedded ) );
+	if (e == NULL) return NULL;
+
+	if (!shared) { /* the first machine sets what all share, see bus.h */
+		shared = 1;
+		if (progname == NULL) progname = "libhawk";
+		ncores = 1;
+		#ifdef __GNUC__
+			engine = ENGINE_THREADED;
+		#else
+			engine = ENGINE_SWITCH;
+		#endif
+	}
+
+	hm = &e->hm;
+	hm->memsize = memsize;
+	hm->romsize = romsize;
+	powerup_memory( hm );
+	decode_init( hm );
+	block_flushall( hm );
+	mmu_flush( hm ); /* the MMU starts with no translations */
+	cpu_reset( hm );
+	return hm;
+}
+
+void hawk_destroy( struct hawk_machine * hm ) {
+	/* give back everything hm holds */
+	decode_free( hm );
+	block_free( hm );
+	#ifdef JIT
+		jit_free( hm );
+	#endif
+	munmap( hm->m, hm->memsize );
+	free( EMBEDDING( hm ) );
+}
+
+int hawk_load( struct hawk_machine * hm, const char * image, size_t len ) {
+	/* load the object file in image, keeping earlier breakpoints */
+	WORD old = hm->breakpoint;
+	int ok;
+
+	ok = powerup_image( hm, image, len );
+	decode_flushall( hm ); /* code may have been loaded over code */
+	if ((hm->breakpoint != old) && (old != 0)) hawk_break( hm, old );
+	return ok;
+}
+
+void hawk_reset( struct hawk_machine * hm ) {
+	/* power up hm again */
+	hm->pc = 0;
+	hm->morecycles = 0;
+	hm->instructions = 0;
+	cpu_reset( hm );
+}
+
+int hawk_run( struct hawk_machine * hm, uint32_t cycles,
+	      uint64_t instructions ) {
+	/* run hm until it stops, and say why */
+	struct embedded * e = EMBEDDING( hm );
+
+	hm->morecycles += hm->cycles;
+	hm->cycles = 0; /* call console() before the first instruction */
+	hm->stop = 0;
+	e->started = 0;
+	e->halted = 0;
+	e->startcycles = hm->morecycles;
+	e->startinstr = hm->instructions;
+	e->cyclelimit = cycles;
+	e->instrlimit = instructions;
+	cpu_run( hm );
+	return hm->stop;
+}
+
+void hawk_stop( struct hawk_machine * hm ) {
+	/* stop hm once the current instruction is done */
+	EMBEDDING( hm )->halted = 1;
+	hm->morecycles += hm->cycles; /* as kbdread does, to give */
+	hm->cycles = 0;               /* console() a look */
+}
+
+int hawk_break( struct hawk_machine * hm, uint32_t addr ) {
+	/* add a breakpoint at addr */
+	struct embedded * e = EMBEDDING( hm );
+	if (hm->breakpoint == 0) {
+		hm->breakpoint = addr & 0xFFFFFFFEUL;
+		return 1;
+	}
+	if (e->nbreaks >= MAXBREAKS) return 0;
+	e->breaks[e->nbreaks++] = addr & 0xFFFFFFFEUL;
+	return 1;
+}
+
+void hawk_unbreak( struct hawk_machine * hm ) {
+	/* remove all breakpoints */
+	hm->breakpoint = 0; /* pc = 0 always stops anyway */
+	EMBEDDING( hm )->nbreaks = 0;
+}
+
+uint32_t hawk_get( struct hawk_machine * hm, int reg ) {
+	/* get reg; psw is always packed between runs */
+	switch (reg) {
+	case HAWK_PC:  return hm->pc;
+	case HAWK_PSW: return hm->psw;
+	case HAWK_TPC: return hm->tpc;
+	case HAWK_TMA: return hm->tma;
+	case HAWK_TSV: return hm->tsv;
+	}
+	if ((reg < 1) || (reg > 15)) return 0;
+	return hm->r[reg];
+}
+
+void hawk_set( struct hawk_machine * hm, int reg, uint32_t val ) {
+	/* set reg; cpu_run unpacks psw */
+	switch (reg) {
+	case HAWK_PC:  hm->pc = val & 0xFFFFFFFEUL; return;
+	case HAWK_PSW: hm->psw = val; return;
+	case HAWK_TPC: hm->tpc = val; return;
+	case HAWK_TMA: hm->tma = val; return;
+	case HAWK_TSV: hm->tsv = val; return;
+	}
+	if ((reg < 1) || (reg > 15)) return;
+	hm->r[reg] = val;
+}
+
+int hawk_read( struct hawk_machine * hm, uint32_t addr, uint32_t * val ) {
+	/* get the word at addr */
+	if (addr >= hm->memsize) return 0;
+	*val = hm->m[addr >> 2];
+	return 1;
+}
+
+int hawk_write( struct hawk_machine * hm, uint32_t addr, uint32_t val ) {
+	/* set the word at addr, which may hold predecoded code */
+	if (addr >= hm->memsize) return 0;
+	hm->m[addr >> 2] = val;
+	DECODE_STORE( hm, addr );
+	return 1;
+}
+
+uint32_t hawk_cycles( struct hawk_machine * hm ) {
+	return hm->cycles + hm->morecycles;
+}
+
+uint64_t hawk_instructions( struct hawk_machine * hm ) {
+	return hm->instructions;
+}
+
+void hawk_devices( struct hawk_machine * hm, hawk_read_fn * read,
+		   hawk_write_fn * write, void * ctx ) {
+	/* give hm devices */
+	struct embedded * e = EMBEDDING( hm );
+	e->read = read;
+	e->write = write;
+	e->ctx = ctx;
+}
+
+void hawk_interrupt( struct hawk_machine * hm, uint32_t bits, int on ) {
+	/* raise or retract interrupt requests of hm */
+	bits &= (WORD)0xFE; /* IRQ1 to IRQ7 */
+	if (on) {
+		hm->irq |= bits;
+	} else {
+		hm->irq &= ~bits;
+	}
+}
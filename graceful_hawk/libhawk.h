@@ -0,0 +1,124 @@
+/* File: libhawk.h
+   Date: Oct. 16, 2026
+   Language: C (UNIX)
+   Purpose: Hawk Emulator, interface to the embeddable emulator library
+*/
+
+/* assumes prior inclusion of <stdint.h> and <stddef.h> */
+
+/*********************
+ * the library       *
+ *********************/
+
+/* make libhawk.a builds the emulator without its console, powerup or
+   main, as a library for programs such as test harnesses and fuzzers
+   that run many short programs in one process; see the Makefile.  Such
+   a program creates machines, loads object files into them from memory
+   and runs them for so many memory cycles or instructions, or until
+   they reach location zero or a breakpoint, reading and writing their
+   registers and memory between runs.  There is no display or keyboard;
+   instead, loads and stores in their address ranges, see bus.h, go to
+   functions the program gives.
+
+   any number of machines may be created, and each may be run on a host
+   thread of its own at the same time as the others, so long as no two
+   threads use one machine at once.  Each machine has one core, run by
+   the threaded engine, or without gcc or clang, by the switch engine.
+*/
+
+struct hawk_machine; /* see machine.h */
+
+/* register numbers for hawk_get and hawk_set; 0 to 15 are R0 to RF */
+#define HAWK_PC  16
+#define HAWK_PSW 17
+#define HAWK_TPC 18
+#define HAWK_TMA 19
+#define HAWK_TSV 20
+
+/* why hawk_run returned */
+#define HAWK_STOP_ZERO    1 /* pc = 0 */
+#define HAWK_STOP_BREAK   2 /* pc = a breakpoint */
+#define HAWK_STOP_CYCLES  3 /* the cycle limit was reached */
+#define HAWK_STOP_INSTR   4 /* the instruction limit was reached */
+#define HAWK_STOP_HOST    5 /* a device called hawk_stop */
+
+/* a machine's devices; read gets the word at addr, write stores val
+   there, where addr is a word address from DISPBASE to DISPLIMIT or
+   KBDBASE to KBDLIMIT, see bus.h, and ctx is as given to hawk_devices */
+typedef uint32_t hawk_read_fn( void * ctx, struct hawk_machine * hm,
+			       uint32_t addr );
+typedef void hawk_write_fn( void * ctx, struct hawk_machine * hm,
+			    uint32_t addr, uint32_t val );
+
+/*****************
+ * machines      *
+ *****************/
+
+struct hawk_machine * hawk_create( uint32_t memsize, uint32_t romsize );
+/* a new machine, powered up, with memsize bytes of memory, the bottom
+   romsize of it ROM, each a multiple of 0x10000 below 0xFF000000, or
+   0 for the defaults in the Makefile; returns NULL if they are bad */
+
+void hawk_destroy( struct hawk_machine * hm );
+/* give back everything hm holds */
+
+int hawk_load( struct hawk_machine * hm, const char * image, size_t len );
+/* load the SMAL object file held in image[0 .. len-1] into hm, which
+   may set a breakpoint, as the hawk program does for its S directive;
+   returns zero, after an error message on stderr, if it is bad */
+
+void hawk_reset( struct hawk_machine * hm );
+/* power hm up again, with pc, psw, irq and the counts zero; memory,
+   the registers and breakpoints are unchanged */
+
+/*****************
+ * running       *
+ *****************/
+
+int hawk_run( struct hawk_machine * hm, uint32_t cycles,
+	      uint64_t instructions );
+/* run hm from its pc until pc = 0 or a breakpoint, or it has used the
+   given number of memory cycles or instructions, either 0 for no limit,
+   and return why, one of HAWK_STOP_...  At most that many instructions
+   run; an instruction that takes more than one memory cycle may carry
+   the count past the cycle limit.  The first instruction always runs,
+   so a machine stopped at a breakpoint or at 0 goes on from there */
+
+void hawk_stop( struct hawk_machine * hm );
+/* called from a device, make hawk_run return HAWK_STOP_HOST once the
+   current instruction is done */
+
+int hawk_break( struct hawk_machine * hm, uint32_t addr );
+/* add a breakpoint at addr; returns zero if there are too many.  With
+   one breakpoint, the machine runs at full speed; with more, it stops
+   to check them after every instruction */
+
+void hawk_unbreak( struct hawk_machine * hm );
+/* remove all breakpoints */
+
+/*****************
+ * the state     *
+ *****************/
+
+uint32_t hawk_get( struct hawk_machine * hm, int reg );
+void hawk_set( struct hawk_machine * hm, int reg, uint32_t val );
+/* get or set reg, 0 to 15 for R0 to RF, or HAWK_PC and so on; R0 is
+   always zero and the pc always even */
+
+int hawk_read( struct hawk_machine * hm, uint32_t addr, uint32_t * val );
+int hawk_write( struct hawk_machine * hm, uint32_t addr, uint32_t val );
+/* get or set the word of memory at addr, ROM included; returns zero if
+   addr is not in memory */
+
+uint32_t hawk_cycles( struct hawk_machine * hm );
+uint64_t hawk_instructions( struct hawk_machine * hm );
+/* the counts of memory cycles and instructions since power up */
+
+void hawk_devices( struct hawk_machine * hm, hawk_read_fn * read,
+		   hawk_write_fn * write, void * ctx );
+/* give hm devices; until this is called, or if read or write is NULL,
+   loads get 0 and stores are ignored */
+
+void hawk_interrupt( struct hawk_machine * hm, uint32_t bits, int on );
+/* raise, if on, or otherwise retract, the interrupt requests in bits,
+   IRQ1 to IRQ7, see bus.h, of hm */
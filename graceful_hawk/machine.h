@@ -0,0 +1,129 @@
+/* File: machine.h
+   Date: Oct. 16, 2026
+   Language: C (UNIX)
+   Purpose: Hawk Emulator, the state of one Hawk machine
+*/
+
+/* assumes prior inclusion of <stdint.h>, "bus.h", "decode.h", "block.h"
+   and "mmu.h" */
+
+/*****************
+ * the machine   *
+ *****************/
+
+/* everything a Hawk CPU changes as it runs is held in one of these,
+   so that any number of them can be run in one process, each by one
+   host thread at a time.  The CPU engines in cpu.c, the device
+   handlers, the coprocessor, the MMU, the loader and the console are
+   all handed the machine they work on, and the translations of the
+   block engine and the JIT are kept in it.  With SMP, see smp.h, each
+   core is a machine of its own, and all of them share the memory and
+   predecode cache of core 0.
+*/
+struct hawk_machine {
+	/* the generally visible registers */
+	WORD r[16];      /* the general purpose registers */
+	WORD pc;         /* the program counter */
+	WORD costat;     /* the coprocessor status register */
+	WORD cocc;       /* condition codes set by coprocessor for COGET */
+	WORD psw;        /* the processor status word */
+	WORD tpc;        /* saved pc after a trap */
+	WORD tma;        /* saved memory address after a trap */
+	WORD tsv;        /* trap save location */
+	WORD irq;        /* interrupt request, see RAISE in bus.h */
+
+	/* count of memory cycles, see bus.h; the sum cycles+morecycles
+	   is the true cycle count */
+	WORD cycles;
+	WORD morecycles;
+	uint64_t instructions; /* fetched, including those that trap */
+
+	/* the performance counters, by CPUGET number, see bus.h; for
+	   CNTINSTR, the instruction count when it was zero */
+	WORD counters[16];
+
+	WORD breakpoint; /* compared with pc to stop at breakpoints */
+	int cpuid;       /* which core this is, 0 to ncores-1, see smp.h */
+	int stop;        /* set by the console to make cpu_run return */
+
+	/* private to cpu.c, the CPU's internal state */
+	WORD ea;         /* the effective address */
+	WORD snoop;      /* the snooping address (LOADL,STOREC) */
+	WORD linked;     /* with SMP, the value of the last LOADL */
+	WORD carries;    /* the carry bits from the adder, part of psw */
+	WORD imask;      /* which interrupts are enabled, from LEVEL */
+	int cclazy;      /* nonzero if psw must be computed from cc* */
+	WORD ccx;        /* the adder's first operand */
+	WORD ccy;        /* the adder's second operand */
+	WORD ccr;        /* the result, ccx + ccy plus carry in */
+	WORD lastpc;     /* the pc used to fetch the current instruction */
+
+	/* the floating point coprocessor, see float.c */
+	double fpa[2];   /* two floating accumulators, in long format */
+	WORD fplow;
+
+	/* the MMU, see mmu.h */
+	struct tlbent tlb[ TLBSIZE ];
+	int tlbnext;     /* the next entry to replace */
+	struct vtlb vtlb[ 1 << VTLBBITS ];
+	WORD vcode;      /* the page of the last instruction */
+	WORD vcodedelta; /* frame - page for vcode */
+	WORD vcodespan;  /* WORDFIELD - 3 while vcode is valid, else 0 */
+
+	/* memory, see bus.h; memory runs from 0 to memsize-1, with ROM
+	   from 0 to romsize-1, and is word addressable */
+	WORD * m;
+	WORD memsize;
+	WORD romsize;
+
+	/* the predecode cache for m, see decode.h */
+	struct decoded * dcache;  /* memsize >> 1 entries */
+	BYTE * dpage;             /* memsize >> DPAGEBITS entries */
+	struct decoded split;     /* scratch, see decode_split */
+
+	/* the profile, see profile.h; prof and calls are NULL unless
+	   profiling */
+	struct profent * prof;     /* memsize >> 1 entries */
+	struct profent * proflast; /* the entry of the last fetch */
+	WORD profcycles;           /* cycles + morecycles at that fetch */
+	struct callstack * calls;  /* the shadow call stack */
+
+	/* the instruction trace, see itrace.h; NULL unless tracing */
+	struct itrace * itrace;
+
+	/* the L1 caches, see cache.h; NULL unless simulated */
+	struct l1cache * l1i;
+	struct l1cache * l1d;
+
+	/* the translated blocks, see block.h; the micro-ops are NULL
+	   until block_flushall is first called */
+	struct block btab[ 1 << BHASHBITS ];
+	struct uop * uops;
+	int nuops;
+
+	/* the host code compiled from them, see jit.h; NULL unless the
+	   JIT was set up */
+	struct jit * jit;
+
+	/* the loader's location counter and relocation base, see
+	   powerup.c, carried from one object file to the next on the
+	   command line; each powerup_image starts them over */
+	WORD lc;
+	WORD rb;
+};
+
+/*********************
+ * running a machine *
+ *********************/
+
+/* the hawk program's main, in cpu.c, runs hawk forever; a program built
+   on libhawk.a, see libhawk.h, has a main of its own and runs machines
+   with these.  Both are in cpu.c */
+
+void cpu_reset( struct hawk_machine * hm );
+/* power up hm: psw, irq and the cycle count zero, ready to run from pc */
+
+void cpu_run( struct hawk_machine * hm );
+/* run hm, from its pc and packed psw, calling console() whenever the
+   console would be called, until console() sets hm->stop; then return,
+   with psw packed and pc the next instruction to run */
@@ -0,0 +1,94 @@
+/* File: mmu.c
+   Date: Oct. 16, 2026
+   Language: C (UNIX)
+   Purpose: Hawk Emulator, memory management unit;
+		a software managed TLB, with a direct mapped cache of
+		translations in front of it for the paged engine in cpu.c.
+*/
+
+#include <inttypes.h>
+#include <stddef.h>
+#include "bus.h"
+#include "decode.h"
+#include "block.h"
+#include "mmu.h"
+#include "machine.h"
+
+/************************
+ * TLB and translations *
+ ************************/
+
+static struct tlbent * lookup( struct hawk_machine * hm, WORD va ) {
+	/* the valid TLB entry of hm for the page of va, or NULL */
+	WORD page = va & PAGEFIELD;
+	int i;
+	for (i = 0; i < TLBSIZE; i++) {
+		struct tlbent * e = &hm->tlb[i];
+		if ((e->page == page) && (e->entry & ARVALID)) return e;
+	}
+	return NULL;
+}
+
+/*************
+ * Interface *
+ *************/
+
+WORD mmu_miss( struct hawk_machine * hm, WORD va, int k ) {
+	/* look up va for access of kind k in the TLB, filling vtlb */
+	static const WORD need[3] = { ARREAD, ARWRITE, AREXEC };
+	struct tlbent * e = lookup( hm, va );
+	struct vtlb * t;
+	WORD frame;
+
+	if ((e == NULL) || !(e->entry & need[k])) return MMU_TRAP;
+	frame = e->entry & PAGEFIELD;
+	if ((k == VEXEC) && (frame >= hm->memsize)) return BUS_TRAP;
+
+	/* cache every access the entry allows, except instruction
+	   fetches beyond memory, so they come back here to trap */
+	t = &hm->vtlb[VTLBINDEX( va )];
+	t->tag[VREAD] = (e->entry & ARREAD) ? e->page : VNONE;
+	t->tag[VWRITE] = (e->entry & ARWRITE) ? e->page : VNONE;
+	t->tag[VEXEC] = ((e->entry & AREXEC) && (frame < hm->memsize))
+		      ? e->page : VNONE;
+	t->delta = frame - e->page;
+	return 0;
+}
+
+void mmu_load( struct hawk_machine * hm, WORD va, WORD entry ) {
+	/* CPUSET TLBLOAD */
+	struct tlbent * e = lookup( hm, va );
+	if (e == NULL) {
+		e = &hm->tlb[hm->tlbnext];
+		hm->tlbnext = (hm->tlbnext + 1) & TLBMASK;
+	}
+	e->page = va & PAGEFIELD;
+	e->entry = entry;
+	mmu_flush( hm );
+}
+
+WORD mmu_get( struct hawk_machine * hm, WORD va ) {
+	/* CPUGET TLBLOAD */
+	struct tlbent * e = lookup( hm, va );
+	return (e != NULL) ? e->entry : 0;
+}
+
+void mmu_clear( struct hawk_machine * hm, WORD all ) {
+	/* CPUSET TLBCLR */
+	int i;
+	for (i = 0; i < TLBSIZE; i++) {
+		if (all || !(hm->tlb[i].entry & ARGLOBAL)) hm->tlb[i].entry = 0;
+	}
+	mmu_flush( hm );
+}
+
+void mmu_flush( struct hawk_machine * hm ) {
+	/* forget all translations in vtlb */
+	int i;
+	hm->vcodespan = 0;
+	for (i = 0; i < (1 << VTLBBITS); i++) {
+		hm->vtlb[i].tag[VREAD] = VNONE;
+		hm->vtlb[i].tag[VWRITE] = VNONE;
+		hm->vtlb[i].tag[VEXEC] = VNONE;
+	}
+}
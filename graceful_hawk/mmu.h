@@ -0,0 +1,106 @@
+/* File: mmu.h
+   Date: Oct. 16, 2026
+   Language: C (UNIX)
+   Purpose: Hawk Emulator, interface to the memory management unit
+*/
+
+/* assumes prior inclusion of <stdint.h> and "bus.h" */
+
+/************************
+ * the architected TLB  *
+ ************************/
+
+/* while the MMU is on (MMUON in psw), every instruction fetch, load and
+   store translates its virtual address through the TLB, a fully
+   associative set of TLBSIZE entries, each mapping one virtual page to
+   one physical page frame.  An address with no valid entry, or whose
+   entry lacks ARREAD, ARWRITE or AREXEC as the access needs, causes an
+   MMU_TRAP with the virtual address in tma.  Instruction fetches from
+   frames beyond memory cause a BUS_TRAP instead.
+
+   each machine has its own TLB, see machine.h, managed by software through
+   CPUSET and CPUGET:
+	CPUSET  x,TLBLOAD  loads an entry: the page is the PAGEFIELD of
+	                   tma, the frame and access rights come from x;
+	                   an entry for that page is replaced, otherwise
+	                   the entries are replaced round-robin
+	CPUGET  x,TLBLOAD  gets the entry for the page of tma, or 0
+	CPUSET  x,TLBCLR   invalidates every entry without ARGLOBAL, or
+	                   every entry if x is nonzero
+   ARCACHE is kept but has no effect.
+*/
+#define TLBLOAD 0x4     /* CPUSET and CPUGET register numbers */
+#define TLBCLR  0x5
+
+struct tlbent {
+	WORD page;      /* virtual address of the page */
+	WORD entry;     /* frame and access rights, as given to TLBLOAD */
+};
+
+/* the TLB is the tlb field of the machine, with tlbnext the next entry
+   to replace */
+
+/******************************
+ * the host translation cache *
+ ******************************/
+
+/* in front of the TLB is a larger direct mapped cache of translations,
+   indexed by virtual page number, see VTLBINDEX; an entry holds, for each kind of
+   access, the page it allows that access to, so a translation that
+   hits costs one compare.  Tags never match if the access is denied,
+   so misses and faults both go to mmu_miss.
+*/
+#define VREAD  0        /* kinds of access, index into tag */
+#define VWRITE 1
+#define VEXEC  2
+
+#define VTLBBITS 8
+#define VTLBMASK ((1 << VTLBBITS) - 1)
+#define VNONE    1      /* a tag that matches no page */
+
+/* the entry for the page of va; folding in the high bits of the page
+   number keeps the low pages of memory and those of the display at the
+   top of the address space from sharing entries */
+#define VTLBINDEX(va) ((((va) >> PAGEBITS) ^ ((va) >> (PAGEBITS + VTLBBITS))) \
+		       & VTLBMASK)
+
+struct vtlb {
+	WORD tag[3];    /* the page, for each kind of access, or VNONE */
+	WORD delta;     /* frame - page */
+};
+
+/* the cache is the vtlb field of the machine; instruction fetches go
+   through a cache of one translation in front of it, vcode, the page
+   the CPU is running in, with vcodedelta its frame - page, since a
+   fetch that waits on a lookup in vtlb delays the dispatch of every
+   instruction.  pc hits when (WORD)(pc - vcode) < vcodespan, one
+   compare that fails for pc outside the page or in its last word;
+   set by cpu.c, vcodespan is reset to 0 by mmu_flush so nothing hits */
+
+/* translate virtual address va for access of kind k to pa on machine
+   h, or trap and do fault; for use in cpu.c, where TRAP is defined */
+#define TRANSLATE(h,va,k,pa,fault) {					\
+	struct vtlb * t_ = &(h)->vtlb[VTLBINDEX( va )];			\
+	if (t_->tag[k] != ((va) & PAGEFIELD)) {				\
+		WORD trap_ = mmu_miss( h, va, k );			\
+		if (trap_) { tma = (va); TRAP( trap_ ); fault; }	\
+	}								\
+	pa = (va) + t_->delta;						\
+}
+
+WORD mmu_miss( struct hawk_machine * hm, WORD va, int k );
+/* look up va for access of kind k in the TLB and fill its vtlb entry;
+   returns 0, or the trap vector if the access faults */
+
+void mmu_load( struct hawk_machine * hm, WORD va, WORD entry );
+/* CPUSET TLBLOAD, va is tma */
+
+WORD mmu_get( struct hawk_machine * hm, WORD va );
+/* CPUGET TLBLOAD, va is tma */
+
+void mmu_clear( struct hawk_machine * hm, WORD all );
+/* CPUSET TLBCLR */
+
+void mmu_flush( struct hawk_machine * hm );
+/* forget all translations in vtlb; call whenever tlb changes, and
+   before a new machine first runs */
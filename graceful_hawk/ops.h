@@ -0,0 +1,795 @@
+/* File: ops.h
+   Date: Oct. 16, 2026
+   Language: C (UNIX)
+   Purpose: Hawk instruction set emulator, the instructions themselves;
+		included by cpu.c once for each execution engine.
+   Constraints:
+	When included, the following must be defined:
+	CASE(k)  label for the instruction with predecoded key 0xk
+	NEXT     go on to the next instruction
+	ILLEGAL  take an instruction trap
+	MMUCHECK leave the engine if psw turned the MMU on or off,
+	         with pc ready for the next instruction
+	LINK(v)  note that LOADL loaded v, see smp.h
+	CALLED(v) note a call to pc that returns to v, see profile.h
+	JUMPED   note a jump to pc that may be a return
+	STORECOND(v) store v for STOREC, setting V if it fails
+	and di must point to the predecoded instruction, see decode.h,
+	and hm to the machine that runs it, see machine.h.
+*/
+
+/***********************************
+ * in all of the following cases,  *
+ * normal exit is by NEXT,         *
+ * meaning fetch the next instr,   *
+ * while abnormal exit is ILLEGAL  *
+ * leading to an instruction trap  *
+ ***********************************/
+
+CASE(FF): /* MOVE */
+	if (DST == 0) ILLEGAL;
+	ea = 0;
+	r[0] = pc;
+	ADDTO(ea,r[X]);
+	r[DST] = ea;
+	NEXT;
+
+CASE(FE): /* MOVECC */
+	ea = 0;
+	r[0] = pc;
+	ADDTOCC(ea,r[X],0);
+	r[DST] = ea;
+	NEXT;
+
+CASE(FD): /* LOADS */
+	r[0] = pc;
+	ea = r[X] & 0xFFFFFFFCUL;
+	LOAD(r[DST]);
+	if (DST != 0) NEXT;
+	pc = r[0];
+	BRANCHCHECK;
+	JUMPED;
+	FETCHW;
+	NEXT;
+
+CASE(FC): /* LOADSCC */
+	r[0] = pc;
+	ea = r[X] & 0xFFFFFFFCUL;
+	LOAD(r[DST]);
+	SETCC(r[DST]);
+	SETNULLS(r[DST]);
+	NEXT;
+
+CASE(FB): /* JSRS */
+	r[0] = pc;
+	ea = r[X];
+	r[DST] = pc;
+	pc = ea;
+	BRANCHCHECK;
+	if (DST != 0) {
+		CALLED(r[DST]);
+	} else {
+		JUMPED;
+	}
+	FETCHW;
+	NEXT;
+
+CASE(FA): /* STORES */
+	if (X == 0) ILLEGAL;
+	r[0] = pc;
+	ea = r[X] & 0xFFFFFFFCUL;
+	r[0] = 0;
+	STORE(r[DST]);
+	NEXT;
+
+CASE(F9): /* -- LOADL, LOADSCC with added snooping */
+	if (X == 0) ILLEGAL;
+	r[0] = pc;
+	ea = r[X] & 0xFFFFFFFCUL;
+	snoop = ea;
+	LOAD(r[DST]);
+	LINK(r[DST]);
+	SETCC(r[DST]);
+	SETNULLS(r[DST]);
+	NEXT;
+
+CASE(F8): /* -- STOREC, STORES with snoop-driven fail */
+	if (X == 0) ILLEGAL;
+	r[0] = pc;
+	ea = r[X] & 0xFFFFFFFCUL;
+	r[0] = 0;
+	FLAGS;
+	psw &= ~(CC | CBITS);
+	if (ea == snoop) {
+		STORECOND(r[DST]);
+	} else {
+		psw |= V;
+	}
+	NEXT;
+
+CASE(F7): /* LEA */
+	#ifdef SPARROWHAWK
+		ILLEGAL;
+	#else
+		if (DST == 0) ILLEGAL;
+		FETCHIMM(ea);
+		r[0] = pc;
+		ADDTO(ea,r[X]);
+		r[DST] = ea;
+		NEXT;
+	#endif
+
+CASE(F6): /* LEACC */
+	#ifdef SPARROWHAWK
+		ILLEGAL;
+	#else
+		FETCHIMM(ea);
+		r[0] = pc;
+		ADDTOCC(ea,r[X],0);
+		r[DST] = ea;
+		NEXT;
+	#endif
+
+CASE(F5): /* LOAD */
+	#ifdef SPARROWHAWK
+		ILLEGAL;
+	#else
+		FETCHIMM(ea);
+		r[0] = pc;
+		ADDTO(ea,r[X]);
+		ea &= 0xFFFFFFFCUL;
+		LOAD(r[DST]);
+		if (DST != 0) NEXT;
+		pc = r[0];
+		BRANCHCHECK;
+		JUMPED;
+		FETCHW;
+		NEXT;
+	#endif
+
+CASE(F4): /* LOADCC */
+	#ifdef SPARROWHAWK
+		ILLEGAL;
+	#else
+		FETCHIMM(ea);
+		r[0] = pc;
+		ADDTO(ea,r[X]);
+		ea &= 0xFFFFFFFCUL;
+		LOAD(r[DST]);
+		SETCC(r[DST]);
+		SETNULLS(r[DST]);
+		NEXT;
+	#endif
+
+CASE(F3): /* JSR */
+	#ifdef SPARROWHAWK
+		ILLEGAL;
+	#else
+		FETCHIMM(ea);
+		r[0] = pc;
+		ADDTO(ea,r[X]);
+		r[DST] = pc;
+		pc = ea;
+		BRANCHCHECK;
+		if (DST != 0) {
+			CALLED(r[DST]);
+		} else {
+			JUMPED;
+		}
+		FETCHW;
+		NEXT;
+	#endif
+
+CASE(F2): /* STORE */
+	#ifdef SPARROWHAWK
+		ILLEGAL;
+	#else
+		FETCHIMM(ea);
+		r[0] = pc;
+		ADDTO(ea,r[X]);
+		ea &= 0xFFFFFFFCUL;
+		r[0] = 0;
+		STORE(r[DST]);
+		NEXT;
+	#endif
+
+CASE(F1): /* -- */
+CASE(F0): /* -- */
+	ILLEGAL;
+
+CASE(E0): /* LIL */
+	#ifdef SPARROWHAWK
+		ILLEGAL;
+	#else
+		FETCHIMM(r[DST]);
+		if (DST != 0) NEXT;
+		pc = r[0];
+		BRANCHCHECK;
+		JUMPED;
+		FETCHW;
+		NEXT;
+	#endif
+
+CASE(D0): /* LIS */
+	if (DST == 0) ILLEGAL;
+	r[DST] = IMM;
+	NEXT;
+
+CASE(C0): /* ORIS */
+	if (DST == 0) ILLEGAL;
+	r[DST] <<= 8;
+	r[DST] |= IMM;
+	NEXT;
+
+CASE(B0): /* MOVESL */
+	if (S1 == 0) ILLEGAL;
+	{
+		int shift = (S2 - 1) & 0xF;
+		WORD d = r[S1];
+		WORD c = d & ~(0x7FFFFFFFUL >> shift);
+		WORD vm = 0x7FFFFFFFUL >> (shift + 1);
+		WORD v = d & ~vm;
+		r[DST] = d << (shift + 1);
+		SETCC(r[DST]);
+		if (c) ORCC(C);
+		if (v) v = (v + vm + 1) & vm;
+		if (v) ORCC(V);
+	}
+	NEXT;
+
+CASE(A0): /* ADDSL */
+	if (DST == 0) ILLEGAL;
+	{
+		int shift = (S2 - 1) & 0xF;
+		WORD d = r[DST];
+		WORD c = d & ~(0x7FFFFFFFUL >> shift);
+		WORD vm = 0x7FFFFFFFUL >> (shift + 1);
+		WORD v = d & ~vm;
+		d <<= (shift + 1);
+		ADDTOCC(d,r[S1],0);
+		r[DST] = d;
+		if (c) ORCC(C);
+		if (v) v = (v + vm + 1) & vm;
+		if (v) ORCC(V);
+	}
+	NEXT;
+
+CASE(90): /* ADDSR */
+	{
+		int shift = ((S2 - 1) & 0xF) + 1;
+		WORD d = r[DST];
+		WORD v;
+		WORD c;
+		WORD m = 0x7FFFFFFFUL >> (shift - 1);
+		ADDTOCC(d,r[S1],0);
+		FLAGS;
+		v = d & ~(0xFFFFFFFFUL << shift);
+		c = d &  (0x00000001UL << (shift - 1));
+		d >>= shift;
+		if (psw & N) {
+			if (psw & V) {  /* neg and ovf */
+				d &= m; /*   make positive */
+			} else {        /* neg and no ovf */
+				d |= ~m;/*   make negative */
+			}
+		} else {
+			if (psw & V) {  /* pos and ovf */
+				d |= ~m;/*   make negative */
+			} else {        /* pos and no ovf */
+				d &= m; /*   make positive */
+			}
+		}
+		SETCC(d);
+		r[DST] = d;
+		if (v) ORCC(V);
+		if (c) ORCC(C);
+	}
+	NEXT;
+
+CASE(80): /* ADDSRU */
+	{
+		int shift = ((S2 - 1) & 0xF) + 1;
+		WORD d = r[DST];
+		WORD v;
+		WORD c;
+		WORD m = 0x7FFFFFFFUL >> (shift - 1);
+		ADDTOCC(d,r[S1],0);
+		FLAGS;
+		v = d & ~(0xFFFFFFFFUL << shift);
+		c = d &  (0x00000001UL << (shift - 1));
+		d >>= shift;
+		d &= m;
+		if (psw & C) {
+			d += (m + 1);
+		}
+		SETCC(d);
+		r[DST] = d;
+		if (v) ORCC(V);
+		if (c) ORCC(C);
+	}
+	NEXT;
+
+CASE(70): /* STUFFB */
+	if (DST == 0) ILLEGAL;
+	{
+		int d = DST;
+		int shift = ((int)(r[S2] & 3)) << 3;
+		WORD mask = ~(0x000000FFUL << shift);
+		r[d] = (r[d] & mask)
+		     | ((r[S1] & 0x000000FFUL) << shift);
+	}
+	NEXT;
+
+CASE(60): /* STUFFH */
+	if (DST == 0) ILLEGAL;
+	{
+		int d = DST;
+		int shift = ((int)(r[S2] & 2)) << 3;
+		WORD mask = ~(0x0000FFFFUL << shift);
+		r[d] = (r[d] & mask)
+		     | ((r[S1] & 0x0000FFFFUL) << shift);
+	}
+	NEXT;
+
+CASE(50): /* EXTB */
+	if (S1 == 0) ILLEGAL;
+	{
+		int shift = ((int)(r[S2] & 3)) << 3;
+		WORD src = r[S1];
+		r[DST] = (src >> shift) & 0x000000FFUL;
+		SETCC(r[DST]);
+	}
+	NEXT;
+
+CASE(40): /* EXTH */
+	if (S1 == 0) ILLEGAL;
+	{
+		int shift = ((int)(r[S2] & 2)) << 3;
+		WORD src = r[S1];
+		r[DST] = (src >> shift) & 0x0000FFFFUL;
+		SETCC(r[DST]);
+	}
+	NEXT;
+
+CASE(30): /* ADD */
+	if (S1 == 0) ILLEGAL;
+	if (S2 == 0) ILLEGAL;
+	{
+		WORD dst = r[S1];
+		ADDTOCC(dst,r[S2],0);
+		r[DST] = dst;
+	}
+	NEXT;
+
+CASE(20): /* SUB */
+	if (S2 == 0) ILLEGAL;
+	{
+		WORD dst = r[S1];
+		ADDTOCC(dst,~r[S2],1);
+		r[DST] = dst;
+	}
+	NEXT;
+
+CASE(1F): /* TRUNC */
+	if (DST == 0) ILLEGAL;
+	{
+		int s = (SRC - 1) & 0xF;
+		WORD m = 0xFFFFFFFFUL << s;
+		WORD d = r[DST];
+		WORD g = d & m;
+		WORD c = d & (m<<1);
+		d &= ~(m<<1);
+		SETCC(d);
+		r[DST] = d;
+		if (c) ORCC(C);
+		if (g) g = (~g) & m;
+		if (g) ORCC(V);
+	}
+	NEXT;
+
+CASE(1E): /* SXT */
+	if (DST == 0) ILLEGAL;
+	{
+		int s = (SRC - 1) & 0xF;
+		WORD m = 0xFFFFFFFFUL << s;
+		WORD d = r[DST];
+		WORD g = d & m;
+		WORD c = d & (m<<1);
+		if (d&((~m)+1)) { /* negative */
+			d |= m;
+		} else { /* positive */
+			d &= ~m;
+		}
+		SETCC(d);
+		r[DST] = d;
+		if (c) ORCC(C);
+		if (g) g = (~g) & m;
+		if (g) ORCC(V);
+	}
+	NEXT;
+
+CASE(1D): /* BTRUNC */
+	if (DST == 0) ILLEGAL;
+	{
+		int s = ((SRC - 1) & 0xF) + 1;
+		WORD ms = 0xFFFFFFFFUL << s;
+		WORD d = r[DST] & ~ms;
+		ADDTO(pc, d << 1);
+		BRANCHCHECK;
+		FETCHW;
+	}
+	NEXT;
+
+CASE(1C): 
+	if (DST == 0){/* DISPLAY */
+		change_display(SRC);	
+	} else /* ADDSI */
+	{
+		ADDTOCC(r[DST], IMM, 0);
+	}
+	NEXT;
+
+CASE(1B): /* AND */
+	if (DST == 0) ILLEGAL;
+	if (SRC == 0) ILLEGAL;
+	r[DST] &= r[SRC];
+	SETCC(r[DST]);
+	NEXT;
+
+CASE(1A): /* OR  */
+	if (DST == 0) ILLEGAL;
+	if (SRC == 0) ILLEGAL;
+	r[DST] |= r[SRC];
+	SETCC(r[DST]);
+	NEXT;
+
+CASE(19): /* EQU */
+	if (DST == 0) ILLEGAL;
+	r[DST] = ~(r[DST] ^ r[SRC]);
+	SETCC(r[DST]);
+	NEXT;
+
+CASE(18): /* --  */
+	ILLEGAL;
+
+CASE(17): /* ADDC */
+	FLAGS;
+	{
+		int nz = (~psw) & Z;
+		ADDTOCC(r[DST], r[SRC], psw & C);
+		FLAGS;
+		if (nz) psw &= ~Z;
+	}
+	NEXT;
+
+CASE(16): /* SUBB */
+	FLAGS;
+	{
+		int nz = (~psw) & Z;
+		ADDTOCC(r[DST], ~r[SRC], psw & C);
+		FLAGS;
+		if (nz) psw &= ~Z;
+	}
+	NEXT;
+
+CASE(15): /* ADJUST */
+	if (DST == 0) ILLEGAL;
+	FLAGS;
+	{
+		WORD src = 0; /* effective source */
+		switch (SRC) { /* decode source */
+
+		case 0x0: /*  */
+		case 0x1: /*  */
+			break;
+
+		case 0x2: /* BCD */
+			src = (carries>>1)
+				& 0x08888888UL;
+			if (psw & C)
+				src |= 0x80000000UL;
+			src = (src >> 1)|(src >> 2);
+			src = (~src) + 1;
+			/* subtract 6 from digits
+			   that didn't produce carry */
+			break;
+
+		case 0x3: /* EX3 */
+			src = (carries>>1)
+				& 0x08888888UL;
+			if (psw & C)
+				src |= 0x80000000UL;
+			src |=   src >> 2      ;
+			src |= ((src << 1) | 1);
+			src ^= 0xCCCCCCCCUL;
+			/* either add or subtract 3
+			   to make correct excess-3 */
+			break;
+
+		case 0x4: /* CMSB */
+			if (psw & C)
+				src = 0x80000000UL;
+			break;
+
+		case 0x5: /* SSQ */
+			if ((psw & N) && (psw & V))
+				src = 0x00000001UL;
+			break;
+
+		case 0x6: /*  */
+		case 0x7: /*  */
+			break;
+
+		case 0x8: /* PLUS1 */
+			src = 1;
+			break;
+
+		case 0x9: /* PLUS2 */
+			src = 2;
+			break;
+
+		case 0xA: /* PLUS4 */
+			src = 4;
+			break;
+
+		case 0xB: /* PLUS8 */
+			src = 8;
+			break;
+
+		case 0xC: /* PLUS16 */
+			src = 16;
+			break;
+
+		case 0xD: /* PLUS32 */
+			src = 32;
+			break;
+
+		case 0xE: /* PLUS64 */
+			src = 64;
+			break;
+
+		case 0xF: /* PLUS128 */
+			src = 128;
+			break;
+		}
+		if (DST != 0) {
+			ADDTO(r[DST],src);
+		}
+	}
+	NEXT;
+
+CASE(14): /* PLUS */
+	if (DST == 0) ILLEGAL;
+	r[0] = pc;
+	WORD dst = r[S1];
+	ADDTO(r[DST],r[S2]);
+	NEXT;
+
+CASE(13): /* COGET */
+    #ifdef SPARROWHAWK
+	ILLEGAL;
+    #else
+	COUNT( CNTCOP );
+	FLAGS;
+	psw &= ~(CC | CBITS); /* always reset cc */
+	if (SRC == 0) {
+		if (costat == 0) psw |= Z;
+		r[DST] = costat;
+		NEXT;
+	} else switch (COSEL) {
+	case 0x0:
+		break; /* missing coprocessor */
+	case 0x1:
+		if (!(costat & COFPENAB)) {
+			TRAP( CO_TRAP );
+			FETCHW;
+			NEXT;
+		}
+		r[DST] = float_coget( hm, SRC );
+		psw |= cocc; /* cond codes from cop */
+		NEXT;
+	case 0x2:
+	case 0x3:
+	case 0x4:
+	case 0x5:
+	case 0x6:
+	case 0x7:
+		break; /* missing coprocessor */
+	}
+	TRAP( CO_TRAP );
+	FETCHW;
+	NEXT;
+    #endif
+
+CASE(12): /* COSET */
+    #ifdef SPARROWHAWK
+	ILLEGAL;
+    #else
+	COUNT( CNTCOP );
+	if (SRC == 0) {
+		costat = r[DST] & COMASK;
+		NEXT;
+	} else switch (COSEL) {
+	case 0x0:
+		break; /* missing coprocessor */
+	case 0x1:
+		if (!(costat & COFPENAB)) {
+			TRAP( CO_TRAP );
+			FETCHW;
+			NEXT;
+		}
+		float_coset( hm, SRC, r[DST] );
+		NEXT;
+	case 0x2:
+	case 0x3:
+	case 0x4:
+	case 0x5:
+	case 0x6:
+	case 0x7:
+		break; /* missing coprocessor */
+	}
+	TRAP( CO_TRAP );
+	FETCHW;
+	NEXT;
+    #endif
+
+CASE(11): /* CPUGET */
+	if ((psw & LEVEL) == LEVEL) { /* all ones */
+		TRAP( PRIV_TRAP );
+		FETCHW;
+		NEXT;
+	}
+	{
+		WORD dst;
+		switch (SRC) { /* decode source */
+
+		case 0x0: /* PSW */
+			PACKPSW;
+			dst = psw;
+			break;
+
+		case 0x1: /* TPC */
+			dst = tpc;
+			break;
+
+		case 0x2: /* TMA */
+			dst = tma;
+			break;
+
+		case 0x3: /* TSV */
+			dst = tsv;
+			break;
+
+		case 0x4: /* TLBLOAD */
+			dst = mmu_get( hm, tma );
+			break;
+
+		case 0x6: /* CORE */
+			dst = ((WORD)ncores << 8) | cpuid;
+			break;
+
+		case 0x5: /* -- */
+		case 0x7: /* -- */
+			break;
+
+		case 0x8: /* CYC */
+			dst = cycles + morecycles;
+			break;
+
+		case 0x9: /* CNTINSTR, see bus.h */
+			dst = (WORD)instructions - hm->counters[CNTINSTR];
+			break;
+
+		case 0xA: /* CNTBRANCH */
+		case 0xB: /* CNTLOAD */
+		case 0xC: /* CNTSTORE */
+		case 0xD: /* CNTTRAP */
+		case 0xE: /* CNTINTR */
+		case 0xF: /* CNTCOP */
+			dst = hm->counters[SRC];
+			break;
+		}
+		if (DST != 0) {
+			r[DST] = dst;
+		} else {
+			pc = dst;
+			psw &= ~LEVEL;
+			psw |= ((psw & OLEVEL) << 4);
+			psw &= ~OLEVEL;
+			BRANCHCHECK;
+			FETCHW;
+			MMUCHECK;
+		}
+	}
+	NEXT;
+	/* control never reaches here */
+
+CASE(10): /* CPUSET */
+	if ((psw & LEVEL) == LEVEL) { /* all ones */
+		TRAP( PRIV_TRAP );
+		FETCHW;
+		NEXT;
+	}
+	switch (SRC) { /* decode terenary opcode */
+
+	case 0x0: /* PSWSET */
+		FLAGS;
+		psw = r[DST];
+		UNPACKPSW;
+		MMUCHECK;
+		NEXT;
+
+	case 0x1: /* TPCSET */
+		tpc = r[DST];
+		NEXT;
+
+	case 0x2: /* TMASET */
+		tma = r[DST];
+		NEXT;
+
+	case 0x3: /* TSVSET */
+		tsv = r[DST];
+		NEXT;
+
+	case 0x4: /* TLBLOAD */
+		mmu_load( hm, tma, r[DST] );
+		NEXT;
+
+	case 0x5: /* TLBCLR */
+		mmu_clear( hm, r[DST] );
+		NEXT;
+
+	case 0x6: /* CORE, interrupt a core, see smp.h */
+		{
+			WORD target = (r[DST] >> 8) & 0xFF;
+			WORD bits = r[DST] & (WORD)0xFE;
+			if (target >= (WORD)ncores) NEXT;
+			if (r[DST] & 1) {
+				RETRACTON( target, bits );
+			} else {
+				RAISEON( target, bits );
+			}
+		}
+		NEXT;
+
+	case 0x7: /* -- */
+		NEXT;
+
+	case 0x8: /* CYCSET */
+		morecycles = r[DST];
+		cycles = 0;
+		NEXT;
+
+	case 0x9: /* CNTINSTR, see bus.h */
+		hm->counters[CNTINSTR] = (WORD)instructions - r[DST];
+		NEXT;
+
+	case 0xA: /* CNTBRANCH */
+	case 0xB: /* CNTLOAD */
+	case 0xC: /* CNTSTORE */
+	case 0xD: /* CNTTRAP */
+	case 0xE: /* CNTINTR */
+	case 0xF: /* CNTCOP */
+		hm->counters[SRC] = r[DST];
+		NEXT;
+
+	}
+	/* control never reaches here */
+	ILLEGAL;
+
+CASE(00): /* Bcc */
+	/* CONST == 0xFF could be illegal, infinite loop */
+	/* CONST == 0xFF could be sleep command */
+	if (DST == 0x8) ILLEGAL;
+	if (COND(DST)) {
+		ADDTO(pc, IMM);
+		BRANCHCHECK;
+		FETCHW;
+	}
+	NEXT;
+
+CASE(100): /* OP_BUSFETCH, instruction ran off the end of memory */
+	tma = IMM;
+	TRAP( BUS_TRAP );
+	FETCHW;
+	NEXT;
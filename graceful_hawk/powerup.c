@@ -2,18 +2,72 @@
    Author: Douglas Jones, Dept. of Comp. Sci., U. of Iowa, Iowa City, IA 52242.
    Date: Mar. 6, 1996
    Revised: Nov. 9, 2023 - (WORD)casting, -Z command line arg, error msgs
+   Revised: Oct. 16, 2026 - -E command line arg selects execution engine
+   Revised: Oct. 16, 2026 - -b, -C and -I command line args for batch mode
+   Revised: Oct. 16, 2026 - -S and -R command line args for snapshots
+   Revised: Oct. 16, 2026 - -M, -m and -H command line args for memory
+   Revised: Oct. 16, 2026 - -P command line arg for more than one core
+   Revised: Oct. 16, 2026 - -J and -j command line args for batches of jobs
+   Revised: Oct. 16, 2026 - load into a machine, see machine.h
+   Revised: Oct. 16, 2026 - add powerup_image for libhawk
+   Revised: Oct. 16, 2026 - -F and -B command line args for the fork server
+   Revised: Oct. 16, 2026 - -p and -L command line args for the profiler
+   Revised: Oct. 16, 2026 - -g command line arg for the call graph
+   Revised: Oct. 16, 2026 - -T command line arg for the timeline
+   Revised: Oct. 16, 2026 - -X command line arg for the instruction trace
+   Revised: Oct. 16, 2026 - -i and -d command line args for the caches
+   Revised: Oct. 16, 2026 - -f command line arg for the display frame rate
    Language: C (UNIX)
    Purpose: Hawk Emulator Power-On support;
 		parses command line arguments and loads object file.
 */
 
 #include <inttypes.h>
+#include <setjmp.h>
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
 #include "bus.h"
+#include "decode.h"
+#include "block.h"
+#include "mmu.h"
+#include "machine.h"
 #include "powerup.h"
+#include "snapshot.h"
+#include "jobs.h"
 
-static FILE *f = NULL;
+/* one load of one object file; the loader keeps nothing between
+   calls, so loads into different machines may go on at once */
+struct loader {
+	struct hawk_machine * hm; /* the machine loaded into */
+	FILE * f;                 /* the object file */
+	jmp_buf * bailout;        /* where to go on an error in it, instead
+				     of exiting, see powerup_image */
+};
+
+/**********
+ * memory *
+ **********/
+
+static int hugepages = 0; /* ask the host for huge pages, from -H */
+
+void powerup_memory(struct hawk_machine * hm) {
+	/* reserve memory for hm, unless it already was, using memsize */
+	void * p;
+	if (hm->m != NULL) return;
+	p = mmap(NULL, hm->memsize, PROT_READ | PROT_WRITE,
+		 MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+	if (p == MAP_FAILED) {
+		fputs(progname, stderr);
+		fputs(": cannot allocate memory\n", stderr);
+		exit(EXIT_FAILURE); /* error */
+	}
+#ifdef MADV_HUGEPAGE
+	if (hugepages) madvise(p, hm->memsize, MADV_HUGEPAGE);
+#endif
+	hm->m = (WORD *)p;
+}
 
 /**************************************
  * error diagnostic output for loader *
@@ -34,8 +88,9 @@ static void diagnose(int c) {
 	}
 }
 
-static void wipeout() {
+static void wipeout(struct loader * ld) {
 	fputs(" in object file **\n", stderr);
+	if (ld->bailout != NULL) longjmp(*ld->bailout, 1);
 	exit(EXIT_FAILURE); /* error */
 }
 
@@ -48,29 +103,26 @@ static void wipeout() {
  * https://homepage.cs.uiowa.edu/~dwjones/cross/smal32/loader.html#load
  */
 
-static WORD lc = 0UL; /* the location counter */
-static WORD rb = 0UL; /* the relocation base */
-
-static void getcheck(char c) {
+static void getcheck(struct loader * ld, char c) {
 	/* get char from SMAL32 object file and verify that it's c */
-	int ch = getc(f);
+	int ch = getc(ld->f);
 	if (ch != c) {
 		fputs("** found '", stderr);
 		diagnose(c);
 		fputs("' where '", stderr);
 		diagnose(ch);
 		fputs("' expected", stderr);
-		wipeout();
+		wipeout(ld);
 	}
 	
 }
 
-static WORD load_value() {
+static WORD load_value(struct loader * ld) {
 	/* parse a load value from SMAL32 object file, up through EOL */
-	int ch = getc(f);
+	int ch = getc(ld->f);
 	if (ch == '#') {
 		WORD value = 0UL;
-		ch = getc(f);
+		ch = getc(ld->f);
 		do {
 			if ((ch >= '0')&&(ch <= '9')) {
 				value = (value << 4) | (ch - '0');
@@ -80,101 +132,223 @@ static WORD load_value() {
 				fputs("** found '", stderr);
 				diagnose(ch);
 				fputs("' where hex digit expected", stderr);
-				wipeout();
+				wipeout(ld);
 			}
-			ch = getc(f);
+			ch = getc(ld->f);
 		} while ((ch != '\n') && (ch != '+'));
 		if (ch == '+') {
-			getcheck('R');
-			getcheck('\n');
-			value += rb;
+			getcheck(ld, 'R');
+			getcheck(ld, '\n');
+			value += ld->hm->rb;
 		} else if (ch != '\n') {
 			fputs("** found '", stderr);
 			diagnose(ch);
 			fputs("' where EOL expected", stderr);
-			wipeout();
+			wipeout(ld);
 		}
 		return value;
 	} else if (ch == ' ') {
-		getcheck('R');
-		getcheck('\n');
-		return rb;
+		getcheck(ld, 'R');
+		getcheck(ld, '\n');
+		return ld->hm->rb;
 	} else {
 		fputs("** found '", stderr);
 		diagnose(ch);
 		fputs("' where load value expected", stderr);
-		wipeout();
+		wipeout(ld);
 	}
 }
 
-static void storebyte(WORD loc, WORD val) {
-	/* store BYTE val in m[loc] */
+static void storebyte(struct loader * ld, WORD loc, WORD val) {
+	/* store BYTE val in m[loc] of the machine loaded into */
+	struct hawk_machine * hm = ld->hm;
 	WORD a = loc >> 2;
 	int s = (loc & (WORD)0x00000003UL) << 3; /* shift count within word */
 	WORD w;
-	if (loc >= MAXMEM) {
+	if (loc >= hm->memsize) {
 		fputs("** invalid load address", stderr);
-		wipeout();
+		wipeout(ld);
 	}
-	w = m[a];
+	w = hm->m[a];
 	w = (w & ~((WORD)0x000000FFUL << s))|((val & (WORD)0x000000FFUL) << s);
-	m[a] = w;
+	hm->m[a] = w;
 }
 
-static void load() {
+static void load(struct loader * ld) {
 	/* load a SMAL32 object file */
+	struct hawk_machine * hm = ld->hm;
 	int ch;
-	ch = getc(f);
+	powerup_memory(hm);
+	ch = getc(ld->f);
 	while (ch != EOF) {
 		if (ch == 'W') {
-			WORD w = load_value();
-			storebyte(lc,     w      );
-			storebyte(lc + 1, w >>  8);
-			storebyte(lc + 2, w >> 16);
-			storebyte(lc + 3, w >> 24);
-			lc += 4;
+			WORD w = load_value(ld);
+			storebyte(ld, hm->lc,     w      );
+			storebyte(ld, hm->lc + 1, w >>  8);
+			storebyte(ld, hm->lc + 2, w >> 16);
+			storebyte(ld, hm->lc + 3, w >> 24);
+			hm->lc += 4;
 		} else if (ch == 'T') {
-			WORD t = load_value();
-			storebyte(lc,     t      );
-			storebyte(lc + 1, t >>  8);
-			storebyte(lc + 2, t >> 16);
-			lc += 3;
+			WORD t = load_value(ld);
+			storebyte(ld, hm->lc,     t      );
+			storebyte(ld, hm->lc + 1, t >>  8);
+			storebyte(ld, hm->lc + 2, t >> 16);
+			hm->lc += 3;
 		} else if (ch == 'H') {
-			WORD h = load_value();
-			storebyte(lc,     h      );
-			storebyte(lc + 1, h >>  8);
-			lc += 2;
+			WORD h = load_value(ld);
+			storebyte(ld, hm->lc,     h      );
+			storebyte(ld, hm->lc + 1, h >>  8);
+			hm->lc += 2;
 		} else if (ch == 'B') {
-			WORD b = load_value();
-			storebyte(lc,     b      );
-			lc += 1;
+			WORD b = load_value(ld);
+			storebyte(ld, hm->lc,     b      );
+			hm->lc += 1;
 		} else if (ch == '.') {
-			getcheck('=');
-			lc = load_value();
+			getcheck(ld, '=');
+			hm->lc = load_value(ld);
 		} else if (ch == 'R') {
-			getcheck('=');
-			getcheck('.');
-			getcheck('\n');
-			rb = lc;
+			getcheck(ld, '=');
+			getcheck(ld, '.');
+			getcheck(ld, '\n');
+			hm->rb = hm->lc;
 		} else if (ch == 'S') {
-			breakpoint = load_value();
-			if (pc & (WORD)0x00000001UL) {
+			hm->breakpoint = load_value(ld);
+			if (hm->pc & (WORD)0x00000001UL) {
 				fputs("** odd start address", stderr);
-				wipeout();
+				wipeout(ld);
 			}
 		} else {
 			fputs("** found '", stderr);
 			diagnose(ch);
 			fputs("' where load directive expected", stderr);
-			wipeout();
+			wipeout(ld);
 		}
-		ch = getc(f);
+		ch = getc(ld->f);
+	}
+}
+
+void powerup_load(struct hawk_machine * hm, const char * name) {
+	/* load the object file name into hm */
+	struct loader ld;
+	ld.hm = hm;
+	ld.bailout = NULL;
+	ld.f = fopen(name, "r");
+	if (ld.f == NULL) {
+		fputs(progname, stderr);
+		fputs(" ", stderr);
+		fputs(name, stderr);
+		fputs(": cannot open object file\n", stderr);
+		exit(EXIT_FAILURE); /* error */
+	}
+	load(&ld);
+	fclose(ld.f);
+}
+
+int powerup_image(struct hawk_machine * hm, const char * image,
+		  size_t len) {
+	/* load the object file held in image[0 .. len-1] into hm, from
+	   location zero, whatever was loaded before */
+	struct loader ld;
+	jmp_buf jb;
+	int ok = 0;
+	hm->lc = 0;
+	hm->rb = 0;
+	ld.hm = hm;
+	ld.bailout = &jb;
+	ld.f = fmemopen((void *)image, len, "r");
+	if (ld.f == NULL) return 0;
+	if (setjmp(jb) == 0) {
+		load(&ld);
+		ok = 1;
+	}
+	fclose(ld.f);
+	return ok;
+}
+
+static char * filename(int argc, char **argv, int i) {
+	/* get the file name argv[i] for the option argv[i-1] */
+	if (i >= argc) {
+		fputs(argv[0], stderr);
+		fputs(" ", stderr);
+		fputs(argv[i-1], stderr);
+		fputs(": missing file name\n", stderr);
+		exit(EXIT_FAILURE); /* error */
+	}
+	return argv[i];
+}
+
+static uint64_t limit(int argc, char **argv, int i) {
+	/* parse the limit argv[i], in decimal or 0x hex, for argv[i-1] */
+	char * e;
+	uint64_t n;
+	if (i >= argc) {
+		fputs(argv[0], stderr);
+		fputs(" ", stderr);
+		fputs(argv[i-1], stderr);
+		fputs(": missing limit\n", stderr);
+		exit(EXIT_FAILURE); /* error */
+	}
+	n = (uint64_t)strtoull(argv[i],&e,0);
+	if ((e == argv[i]) || (*e != '\0')) {
+		fputs(argv[0], stderr);
+		fputs(" ", stderr);
+		fputs(argv[i-1], stderr);
+		fputs(" ", stderr);
+		fputs(argv[i], stderr);
+		fputs(": bad number\n", stderr);
+		exit(EXIT_FAILURE); /* error */
 	}
+	return n;
 }
 
-void powerup(int argc, char **argv) {
+#ifdef CACHE
+static char * cache(int argc, char **argv, int i) {
+	/* get the cache description argv[i] for the option argv[i-1] */
+	if (i >= argc) {
+		fputs(argv[0], stderr);
+		fputs(" ", stderr);
+		fputs(argv[i-1], stderr);
+		fputs(": missing bytes,ways,line\n", stderr);
+		exit(EXIT_FAILURE); /* error */
+	}
+	return argv[i];
+}
+#endif
+
+static WORD size(struct hawk_machine * hm, int argc, char **argv, int i) {
+	/* parse the memory size argv[i] for the option argv[i-1] */
+	uint64_t n = limit(argc, argv, i);
+	if ((n & 0xFFFF) || (n >= IOSPACE)) {
+		fputs(argv[0], stderr);
+		fputs(" ", stderr);
+		fputs(argv[i-1], stderr);
+		fputs(" ", stderr);
+		fputs(argv[i], stderr);
+		fputs(": not a multiple of 0x10000 below 0xFF000000\n", stderr);
+		exit(EXIT_FAILURE); /* error */
+	}
+	if (hm->m != NULL) {
+		fputs(argv[0], stderr);
+		fputs(" ", stderr);
+		fputs(argv[i-1], stderr);
+		fputs(": must come before object files and snapshots\n", stderr);
+		exit(EXIT_FAILURE); /* error */
+	}
+	return (WORD)n;
+}
+
+void powerup(struct hawk_machine * hm, int argc, char **argv) {
 	int i;
-	recycle = 20; /* by default update console display every 20 mem refs */
+	char * manifest = NULL; /* from -J */
+	char * breakname = NULL; /* from -B */
+	WORD breakaddr = 0;
+	int loaded = 0;         /* nonzero once an object file is loaded */
+	progname = argv[0];
+	hm->memsize = MAXMEM; /* by default, memory size is set in Makefile */
+	hm->romsize = MAXROM;
+	recycle = 4096; /* by default look every 4096 mem refs if an update */
+	framerate = 30; /* of the console display is due, 30 times a second */
+	ncores = 1;
 
 	for (i = 1; i < argc; i++) { /* for each argument */
 		if (argv[i][0] == '-') {
@@ -182,8 +356,9 @@ void powerup(int argc, char **argv) {
 				i++;
 				if (i < argc) {
 					char * e;
-					recycle == (WORD)strtol(argv[i],&e,10);
-					if ((e == argv[i]) || (*e != '\0')){
+					recycle = (WORD)strtol(argv[i],&e,10);
+					if ((e == argv[i]) || (*e != '\0')
+					||  (recycle == 0)) {
 						fputs(argv[0], stderr);
 						fputs(" -Z ", stderr);
 						fputs(argv[i], stderr);
@@ -196,9 +371,144 @@ void powerup(int argc, char **argv) {
 					fputs(": missing sleep time\n", stderr);
 					exit(EXIT_FAILURE); /* error */
 				}
+			} else if ((argv[i][1] == 'f')&&(argv[i][2] == '\0')) {
+				uint64_t n;
+				i++;
+				n = limit(argc, argv, i);
+				if ((n < 1) || (n > 1000)) {
+					fputs(argv[0], stderr);
+					fputs(" -f ", stderr);
+					fputs(argv[i], stderr);
+					fputs(": bad frame rate\n", stderr);
+					exit(EXIT_FAILURE); /* error */
+				}
+				framerate = (WORD)n;
+			} else if ((argv[i][1] == 'E')&&(argv[i][2] == '\0')) {
+				i++;
+				if (i < argc) {
+					if (!strcmp(argv[i], "switch")) {
+						engine = ENGINE_SWITCH;
+#ifdef __GNUC__
+					} else if (!strcmp(argv[i], "threaded")) {
+						engine = ENGINE_THREADED;
+#endif
+					} else if (!strcmp(argv[i], "block")) {
+						engine = ENGINE_BLOCK;
+#ifdef JIT
+					} else if (!strcmp(argv[i], "jit")) {
+						engine = ENGINE_JIT;
+#endif
+					} else {
+						fputs(argv[0], stderr);
+						fputs(" -E ", stderr);
+						fputs(argv[i], stderr);
+						fputs(": unknown engine\n", stderr);
+						exit(EXIT_FAILURE); /* error */
+					}
+				} else {
+					fputs(argv[0], stderr);
+					fputs(" -E", stderr);
+					fputs(": missing engine\n", stderr);
+					exit(EXIT_FAILURE); /* error */
+				}
+			} else if ((argv[i][1] == 'b')&&(argv[i][2] == '\0')) {
+				batch = 1;
+			} else if ((argv[i][1] == 'C')&&(argv[i][2] == '\0')) {
+				i++;
+				cyclelimit = (WORD)limit(argc, argv, i);
+			} else if ((argv[i][1] == 'I')&&(argv[i][2] == '\0')) {
+				i++;
+				instrlimit = limit(argc, argv, i);
+			} else if ((argv[i][1] == 'M')&&(argv[i][2] == '\0')) {
+				i++;
+				hm->memsize = size(hm, argc, argv, i);
+			} else if ((argv[i][1] == 'm')&&(argv[i][2] == '\0')) {
+				i++;
+				hm->romsize = size(hm, argc, argv, i);
+			} else if ((argv[i][1] == 'H')&&(argv[i][2] == '\0')) {
+				hugepages = 1;
+#ifdef SMP
+			} else if ((argv[i][1] == 'P')&&(argv[i][2] == '\0')) {
+				uint64_t n;
+				i++;
+				n = limit(argc, argv, i);
+				if ((n < 1) || (n > MAXCORES)) {
+					fputs(argv[0], stderr);
+					fputs(" -P ", stderr);
+					fputs(argv[i], stderr);
+					fputs(": bad number of cores\n", stderr);
+					exit(EXIT_FAILURE); /* error */
+				}
+				ncores = (int)n;
+#endif
+#ifdef PROFILE
+			} else if ((argv[i][1] == 'p')&&(argv[i][2] == '\0')) {
+				i++;
+				profname = filename(argc, argv, i);
+			} else if ((argv[i][1] == 'g')&&(argv[i][2] == '\0')) {
+				i++;
+				foldname = filename(argc, argv, i);
+			} else if ((argv[i][1] == 'T')&&(argv[i][2] == '\0')) {
+				i++;
+				timename = filename(argc, argv, i);
+			} else if ((argv[i][1] == 'L')&&(argv[i][2] == '\0')) {
+				i++;
+				listname = filename(argc, argv, i);
+#endif
+#ifdef ITRACE
+			} else if ((argv[i][1] == 'X')&&(argv[i][2] == '\0')) {
+				i++;
+				itracename = filename(argc, argv, i);
+#endif
+#ifdef CACHE
+			} else if ((argv[i][1] == 'i')&&(argv[i][2] == '\0')) {
+				i++;
+				l1iname = cache(argc, argv, i);
+			} else if ((argv[i][1] == 'd')&&(argv[i][2] == '\0')) {
+				i++;
+				l1dname = cache(argc, argv, i);
+#endif
+			} else if ((argv[i][1] == 'J')&&(argv[i][2] == '\0')) {
+				i++;
+				manifest = filename(argc, argv, i);
+			} else if ((argv[i][1] == 'j')&&(argv[i][2] == '\0')) {
+				i++;
+				workers = (int)limit(argc, argv, i);
+			} else if ((argv[i][1] == 'F')&&(argv[i][2] == '\0')) {
+				i++;
+				forkname = filename(argc, argv, i);
+				batch = 1;
+			} else if ((argv[i][1] == 'B')&&(argv[i][2] == '\0')) {
+				i++;
+				breakname = argv[i];
+				breakaddr = (WORD)limit(argc, argv, i);
+			} else if ((argv[i][1] == 'S')&&(argv[i][2] == '\0')) {
+				i++;
+				snapname = filename(argc, argv, i);
+			} else if ((argv[i][1] == 'R')&&(argv[i][2] == '\0')) {
+				i++;
+				snapshot_restore(hm, filename(argc, argv, i));
 			} else if ((argv[i][1] == '?')&&(argv[i][2] == '\0')) {
 				fputs(argv[0], stderr);
-				fputs(" [-Z cycles] load file list\n", stderr);
+				fputs(" [-Z cycles] [-f rate] [-E engine] [-b] [-C cycles]"
+				      " [-I count] [-M bytes] [-m bytes] [-H]"
+#ifdef SMP
+				      " [-P cores]"
+#endif
+#ifdef PROFILE
+				      " [-p report] [-g folded] [-T timeline]"
+				      " [-L listing]"
+#endif
+#ifdef ITRACE
+				      " [-X trace]"
+#endif
+#ifdef CACHE
+				      " [-i cache] [-d cache]"
+#endif
+				      " [-S snapshot] [-R snapshot]"
+				      " [-J manifest] [-j workers]"
+				      " [-F inputs] [-B address]"
+				      " load file list\n", stderr);
 				exit(EXIT_SUCCESS); /* error */
 			} else {
 				fputs(argv[0], stderr);
@@ -208,17 +518,79 @@ void powerup(int argc, char **argv) {
 				exit(EXIT_FAILURE); /* error */
 			}
                 } else {
-			f = fopen(argv[i], "r");
-			if (f == NULL) {
-				fputs(argv[0], stderr);
-				fputs(" ", stderr);
-				fputs(argv[i], stderr);
-				fputs(": cannot open object file\n", stderr);
-				exit(EXIT_FAILURE); /* error */
-			}
-			load();
-			fclose(f);
-			f = NULL;
+			powerup_load(hm, argv[i]);
+			loaded = 1;
+		}
+	}
+	if (hm->romsize > hm->memsize) {
+		fputs(argv[0], stderr);
+		fputs(": ROM bigger than memory\n", stderr);
+		exit(EXIT_FAILURE); /* error */
+	}
+	if (breakname != NULL) { /* overrides the object file's */
+		if (breakaddr & 1) {
+			fputs(argv[0], stderr);
+			fputs(" -B ", stderr);
+			fputs(breakname, stderr);
+			fputs(": odd address\n", stderr);
+			exit(EXIT_FAILURE); /* error */
+		}
+		hm->breakpoint = breakaddr;
+	}
+	if ((forkname != NULL) && (hm->breakpoint == 0)) {
+		/* the server forks its jobs at the breakpoint, see batch.c */
+		fputs(argv[0], stderr);
+		fputs(" -F: no breakpoint, give -B or an S directive\n",
+		      stderr);
+		exit(EXIT_FAILURE); /* error */
+	}
+	if (ncores > 1) { /* see smp.h */
+		if ((snapname != NULL) || restored) {
+			fputs(argv[0], stderr);
+			fputs(" -P: no snapshots with more than one core\n",
+			      stderr);
+			exit(EXIT_FAILURE); /* error */
+		}
+		if (forkname != NULL) {
+			fputs(argv[0], stderr);
+			fputs(" -P: no fork server with more than one core\n",
+			      stderr);
+			exit(EXIT_FAILURE); /* error */
+		}
+		if (engine >= ENGINE_BLOCK) engine = ENGINE_SWITCH;
+	}
+	if ((profname != NULL) || (foldname != NULL)
+	||  (timename != NULL)) { /* see profile.h */
+		if (engine >= ENGINE_BLOCK) engine = ENGINE_SWITCH;
+	}
+	if (itracename != NULL) { /* see itrace.h */
+		if (forkname != NULL) {
+			fputs(argv[0], stderr);
+			fputs(" -X: no instruction trace with the fork server\n",
+			      stderr);
+			exit(EXIT_FAILURE); /* error */
+		}
+		if (engine >= ENGINE_BLOCK) engine = ENGINE_SWITCH;
+	}
+	if ((l1iname != NULL) || (l1dname != NULL)) { /* see cache.h */
+		if (forkname != NULL) {
+			fputs(argv[0], stderr);
+			fputs(": no cache simulation with the fork server\n",
+			      stderr);
+			exit(EXIT_FAILURE); /* error */
+		}
+		if (engine >= ENGINE_BLOCK) engine = ENGINE_SWITCH;
+	}
+	if (manifest != NULL) { /* see jobs.h */
+		if (loaded || (snapname != NULL) || (forkname != NULL)
+		||  (profname != NULL) || (foldname != NULL)
+		||  (timename != NULL) || (itracename != NULL)) {
+			fputs(argv[0], stderr);
+			fputs(" -J: no object files, -S, -F, profiling or"
+			      " tracing with a manifest\n", stderr);
+			exit(EXIT_FAILURE); /* error */
 		}
+		jobs_run(hm, manifest, workers); /* returns only in a job */
 	}
+	powerup_memory(hm); /* in case nothing was loaded */
 }
@@ -1,10 +1,27 @@
 /* File: powerup.h
    Author: Douglas Jones, Dept. of Comp. Sci., U. of Iowa, Iowa City, IA 52242.
    Date: Nov. 7, 2019
+   Revised: Oct. 16, 2026 - add powerup_memory
+   Revised: Oct. 16, 2026 - add powerup_load
+   Revised: Oct. 16, 2026 - add powerup_image
    Language: C (UNIX)
    Purpose: Hawk Emulator Power-On support interface;
 */
 
-/* assumes prior inclusion of <stdint.h> and "bus.h" */
+/* assumes prior inclusion of <stdint.h>, <stddef.h> and "bus.h" */
 
-void powerup(int argc, char **argv);
+/* each of these works on the machine hm, see machine.h */
+
+void powerup(struct hawk_machine * hm, int argc, char **argv);
+
+void powerup_memory(struct hawk_machine * hm);
+/* reserve memory, unless it already was, using memsize */
+
+void powerup_load(struct hawk_machine * hm, const char * name);
+/* load the object file name, or exit with an error message */
+
+int powerup_image(struct hawk_machine * hm, const char * image,
+		  size_t len);
+/* load the object file held in image[0 .. len-1], starting over from
+   location zero; returns zero, after an error message, if it is not a
+   valid object file */
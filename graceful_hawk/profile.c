@@ -0,0 +1,571 @@
+/* File: profile.c
+   Date: Oct. 16, 2026
+   Language: C (UNIX)
+   Purpose: Hawk Emulator, execution profiler;
+		reports where the program spent its cycles, by address,
+		with the disassembly and the labels from a SMAL listing,
+		and by chain of subroutine calls, and traces the calls.
+*/
+
+#include <ctype.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include "bus.h"
+#include "decode.h"
+#include "block.h"
+#include "mmu.h"
+#include "machine.h"
+#include "showop.h"
+#include "profile.h"
+
+static struct hawk_machine * prof = NULL; /* the machine profiled */
+static const char * reportname;           /* from -p, or NULL */
+static const char * foldedname;           /* from -g, or NULL */
+static struct profent before;             /* charged until the first fetch */
+
+static void fail( const char * name, const char * why ) {
+	fputs( progname, stderr );
+	fputs( " ", stderr );
+	fputs( name, stderr );
+	fputs( why, stderr );
+	exit( EXIT_FAILURE ); /* error */
+}
+
+/*****************
+ * labels        *
+ *****************/
+
+struct label {
+	WORD addr;
+	char * name;
+};
+
+static struct label * labels = NULL; /* sorted by address */
+static int nlabels = 0;
+static int labelmax = 0;
+
+static void addlabel( WORD addr, const char * name, size_t len ) {
+	if (nlabels >= labelmax) {
+		labelmax = (labelmax * 2) + 64;
+		labels = realloc( labels, sizeof( struct label ) * labelmax );
+		if (labels == NULL) fail( "-L", ": out of memory\n" );
+	}
+	labels[nlabels].addr = addr;
+	labels[nlabels].name = strndup( name, len );
+	nlabels++;
+}
+
+static int islabel( const char * w, size_t len ) {
+	/* is w[0 .. len-1] an identifier followed by a colon? */
+	size_t i;
+	if ((len < 2) || (w[len - 1] != ':')) return 0;
+	if (!isalpha( (unsigned char)w[0] ) && (w[0] != '_')) return 0;
+	for (i = 1; i < len - 1; i++) {
+		if (!isalnum( (unsigned char)w[i] ) && (w[i] != '_')) return 0;
+	}
+	return 1;
+}
+
+static int isaddress( const char * w, size_t len, WORD * addr ) {
+	/* is w[0 .. len-1] a hex location, as in +00001C: or 00001C: ? */
+	char * e;
+	if ((len < 3) || (w[len - 1] != ':')) return 0;
+	if (*w == '+') {
+		w++;
+		len--;
+	}
+	if (!isxdigit( (unsigned char)w[0] )) return 0;
+	*addr = (WORD)strtoul( w, &e, 16 );
+	return (e == w + len - 1) && (len >= 5);
+}
+
+static int bylabel( const void * a, const void * b ) {
+	const struct label * la = a;
+	const struct label * lb = b;
+	if (la->addr == lb->addr) return 0;
+	return (la->addr < lb->addr) ? -1 : 1;
+}
+
+static void readlisting( const char * listing ) {
+	/* find the labels in the SMAL listing; each line that assembles
+	   anything shows its location, and a label on it, or on the lines
+	   with no location before it, labels that location */
+	FILE * f = fopen( listing, "r" );
+	char * line = NULL;
+	size_t size = 0;
+	int pending = 0; /* labels still waiting for a location */
+	WORD addr = 0;
+
+	if (f == NULL) fail( listing, ": cannot open listing\n" );
+	while (getline( &line, &size, f ) >= 0) {
+		char * w = line;
+		int located = 0;
+		for (;;) {
+			size_t len;
+			while (isspace( (unsigned char)*w )) w++;
+			if ((*w == '\0') || (*w == ';')) break;
+			len = strcspn( w, " \t\r\n;" );
+			if (!located && isaddress( w, len, &addr )) {
+				int i;
+				located = 1;
+				for (i = nlabels - pending; i < nlabels; i++) {
+					labels[i].addr = addr;
+				}
+				pending = 0;
+			} else if (islabel( w, len )) {
+				addlabel( addr, w, len - 1 );
+				if (!located) pending++;
+			}
+			w += len;
+		}
+	}
+	nlabels -= pending; /* labels on the last lines label nothing */
+	free( line );
+	fclose( f );
+	qsort( labels, nlabels, sizeof( struct label ), bylabel );
+}
+
+static struct label * labelof( WORD addr ) {
+	/* the last label at or below addr, or NULL */
+	int lo = 0;
+	int hi = nlabels;
+	while (lo < hi) { /* labels[lo-1] <= addr < labels[hi] */
+		int mid = (lo + hi) / 2;
+		if (labels[mid].addr <= addr) {
+			lo = mid + 1;
+		} else {
+			hi = mid;
+		}
+	}
+	if (lo == 0) return NULL;
+	return &labels[lo - 1];
+}
+
+static void where( WORD a, char * s, size_t size, const char * none ) {
+	/* put the label of a in s, with an offset if it is not exactly at
+	   a, or if a has no label, none, with a in it, as for printf */
+	struct label * l = labelof( a );
+	if (l == NULL) {
+		snprintf( s, size, none, a );
+	} else if (l->addr == a) {
+		snprintf( s, size, "%s", l->name );
+	} else {
+		snprintf( s, size, "%s+%"PRIX32, l->name, a - l->addr );
+	}
+}
+
+/*****************
+ * the call tree *
+ *****************/
+
+/* each distinct chain of calls is a node in a tree, the chain to the
+   node's parent plus one call more; a node's cycles are those used
+   while its chain was the one active */
+struct node {
+	WORD entry;            /* the address the last call went to */
+	struct node * parent;
+	struct node * child;   /* the first routine it called */
+	struct node * sibling; /* the next routine its parent called */
+	uint64_t self;         /* cycles used with this chain on top */
+	uint64_t calls;        /* times this chain was entered */
+	char * name;           /* of the routine, once traced */
+};
+
+/* the shadow call stack; each frame holds what a return goes back to */
+struct frame {
+	struct node * caller;
+	WORD link;             /* the return address */
+};
+
+struct callstack {
+	struct node root;      /* the program, before any call */
+	struct node * top;     /* the chain active now */
+	struct frame stack[ MAXDEPTH ];
+	int depth;
+	WORD last;             /* cycles + morecycles when top was charged */
+	uint64_t clock;        /* cycles charged in all, for the timeline */
+};
+
+static void charge( struct hawk_machine * hm ) {
+	/* charge the active chain with the cycles used since it was last */
+	struct callstack * cs = hm->calls;
+	WORD now = hm->cycles + hm->morecycles;
+	WORD used = now - cs->last;
+	cs->top->self += used;
+	cs->clock += used;
+	cs->last = now;
+}
+
+/*****************
+ * the timeline  *
+ *****************/
+
+/* trace events are put in a buffer of their own, written out whenever
+   it is nearly full, so that an event costs little more than copying
+   its text; no event is longer than EVENTMAX */
+#define EVENTMAX (NAME_LENGTH + 64)
+
+static FILE * trace = NULL;      /* from -T, or NULL */
+static const char * tracename;
+static char tbuf[ 1 << 16 ];
+static size_t tlen = 0;
+
+static void tflush() {
+	if (fwrite( tbuf, 1, tlen, trace ) != tlen) {
+		fputs( progname, stderr );
+		fputs( " -T ", stderr );
+		fputs( tracename, stderr );
+		fputs( ": cannot write trace\n", stderr );
+		fclose( trace );
+		trace = NULL; /* give up on it */
+	}
+	tlen = 0;
+}
+
+static void tput( const char * s ) {
+	while (*s != '\0') tbuf[tlen++] = *s++;
+}
+
+static void tnum( uint64_t n ) {
+	char d[24];
+	int i = 0;
+	do {
+		d[i++] = '0' + (n % 10);
+		n = n / 10;
+	} while (n != 0);
+	while (i > 0) tbuf[tlen++] = d[--i];
+}
+
+static void event( const char * ph, struct node * n, uint64_t ts ) {
+	/* put an event for n, "B" when it begins or "E" when it ends */
+	if (tlen > sizeof( tbuf ) - EVENTMAX) tflush();
+	if (trace == NULL) return;
+	tput( ",\n{\"ph\":\"" );
+	tput( ph );
+	tput( "\",\"pid\":1,\"tid\":0,\"ts\":" );
+	tnum( ts );
+	if (*ph == 'B') {
+		if (n->name == NULL) {
+			char name[NAME_LENGTH];
+			where( n->entry, name, sizeof( name ), "#%06"PRIX32 );
+			n->name = strdup( name );
+			if (n->name == NULL) n->name = "?";
+		}
+		tput( ",\"name\":\"" );
+		tput( n->name );
+		tput( "\"" );
+	}
+	tput( "}" );
+}
+
+static void starttrace( struct callstack * cs ) {
+	/* begin the timeline with the whole program */
+	tput( "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n"
+	      "{\"ph\":\"M\",\"pid\":1,\"name\":\"process_name\","
+	      "\"args\":{\"name\":\"hawk\"}}" );
+	event( "B", &cs->root, cs->clock );
+}
+
+static void endtrace( struct callstack * cs ) {
+	/* end everything still running, and the timeline */
+	int i;
+	for (i = cs->depth; i >= 0; i--) event( "E", NULL, cs->clock );
+	if (trace == NULL) return;
+	tput( "\n]}\n" );
+	tflush();
+	if (trace != NULL) fclose( trace );
+}
+
+/*****************
+ * calls         *
+ *****************/
+
+void profile_call( struct hawk_machine * hm, WORD link ) {
+	/* a call to pc, returning to link */
+	struct callstack * cs = hm->calls;
+	struct node * n;
+
+	charge( hm );
+	if (cs->depth >= MAXDEPTH) return;
+	for (n = cs->top->child; n != NULL; n = n->sibling) {
+		if (n->entry == hm->pc) break;
+	}
+	if (n == NULL) { /* a new chain */
+		n = calloc( 1, sizeof( struct node ) );
+		if (n == NULL) return;
+		n->entry = hm->pc;
+		n->parent = cs->top;
+		n->sibling = cs->top->child;
+		cs->top->child = n;
+	}
+	n->calls++;
+	cs->stack[cs->depth].caller = cs->top;
+	cs->stack[cs->depth].link = link;
+	cs->depth++;
+	cs->top = n;
+	if (trace != NULL) event( "B", n, cs->clock );
+}
+
+void profile_jump( struct hawk_machine * hm ) {
+	/* a jump to pc, a return if pc is a return address on the stack */
+	struct callstack * cs = hm->calls;
+	int i;
+
+	charge( hm );
+	for (i = cs->depth - 1; i >= 0; i--) {
+		if (cs->stack[i].link == hm->pc) {
+			if (trace != NULL) { /* each routine returned from */
+				int j;
+				for (j = cs->depth; j > i; j--) {
+					event( "E", NULL, cs->clock );
+				}
+			}
+			cs->top = cs->stack[i].caller;
+			cs->depth = i;
+			return;
+		}
+	}
+}
+
+/*****************
+ * routines      *
+ *****************/
+
+/* the routines, one per address called, found from the call tree */
+struct routine {
+	WORD entry;
+	uint64_t calls;
+	uint64_t self;         /* cycles used in it */
+	uint64_t total;        /* cycles used in it and those it called */
+};
+
+static struct routine * routines = NULL;
+static int nroutines = 0;
+
+static struct routine * routineof( WORD entry ) {
+	/* the routine entered at entry; NULL if out of memory */
+	int i;
+	for (i = 0; i < nroutines; i++) {
+		if (routines[i].entry == entry) return &routines[i];
+	}
+	if ((nroutines & 63) == 0) {
+		struct routine * r = realloc( routines,
+			sizeof( struct routine ) * (nroutines + 64) );
+		if (r == NULL) return NULL;
+		routines = r;
+	}
+	memset( &routines[nroutines], 0, sizeof( struct routine ) );
+	routines[nroutines].entry = entry;
+	return &routines[nroutines++];
+}
+
+static uint64_t tally( struct node * n ) {
+	/* add the subtree n to the routines, returning its cycles; its
+	   cycles are inclusive for its routine unless the routine is
+	   already active in a chain that n extends */
+	struct routine * r = routineof( n->entry );
+	struct node * c;
+	uint64_t total = n->self;
+
+	for (c = n->child; c != NULL; c = c->sibling) total += tally( c );
+	if (r != NULL) {
+		r->calls += n->calls;
+		r->self += n->self;
+		for (c = n->parent; c != NULL; c = c->parent) {
+			if (c->entry == n->entry) break;
+		}
+		if (c == NULL) r->total += total;
+	}
+	return total;
+}
+
+static int byinclusive( const void * a, const void * b ) {
+	const struct routine * ra = a;
+	const struct routine * rb = b;
+	if (ra->total != rb->total) return (ra->total > rb->total) ? -1 : 1;
+	if (ra->self != rb->self) return (ra->self > rb->self) ? -1 : 1;
+	return (ra->entry < rb->entry) ? -1 : 1;
+}
+
+static void writeroutines( FILE * f ) {
+	/* add the routines to the report */
+	struct callstack * cs = prof->calls;
+	uint64_t total = tally( &cs->root );
+	int i;
+
+	qsort( routines, nroutines, sizeof( struct routine ), byinclusive );
+	fprintf( f, "\n%d routines, by cycles in them and those they call\n",
+		 nroutines );
+	fputs( "   inclusive      %     exclusive      %         calls"
+	       "  address  routine\n", f );
+	for (i = 0; i < nroutines; i++) {
+		struct routine * r = &routines[i];
+		char name[NAME_LENGTH];
+		where( r->entry, name, sizeof( name ), "" );
+		fprintf( f, "%12"PRIu64" %6.2f %13"PRIu64" %6.2f %13"PRIu64
+			 "  %06"PRIX32"  %s\n", r->total,
+			 (total == 0) ? 0.0 : (100.0 * r->total) / total,
+			 r->self,
+			 (total == 0) ? 0.0 : (100.0 * r->self) / total,
+			 r->calls, r->entry, name );
+	}
+}
+
+static void fold( FILE * f, struct node * n, struct node ** chain, int d ) {
+	/* put a line for each chain in the subtree n, which is chain[d] */
+	struct node * c;
+	chain[d] = n;
+	if (n->self != 0) {
+		int i;
+		for (i = 0; i <= d; i++) {
+			char name[NAME_LENGTH];
+			where( chain[i]->entry, name, sizeof( name ), "#%06"PRIX32 );
+			if (i > 0) putc( ';', f );
+			fputs( name, f );
+		}
+		fprintf( f, " %"PRIu64"\n", n->self );
+	}
+	for (c = n->child; c != NULL; c = c->sibling) fold( f, c, chain, d + 1 );
+}
+
+static void writefolded() {
+	/* write the call tree of prof to foldedname */
+	struct node * chain[ MAXDEPTH + 1 ];
+	FILE * f = fopen( foldedname, "w" );
+	if (f == NULL) {
+		fputs( progname, stderr );
+		fputs( " -g ", stderr );
+		fputs( foldedname, stderr );
+		fputs( ": cannot write call graph\n", stderr );
+		return;
+	}
+	fold( f, &prof->calls->root, chain, 0 );
+	fclose( f );
+}
+
+/*****************
+ * the report    *
+ *****************/
+
+static int byhotness( const void * a, const void * b ) {
+	/* order entries by cycles, then count, hottest first */
+	const struct profent * pa = *(struct profent * const *)a;
+	const struct profent * pb = *(struct profent * const *)b;
+	if (pa->used != pb->used) {
+		return (pa->used > pb->used) ? -1 : 1;
+	}
+	if (pa->count != pb->count) return (pa->count > pb->count) ? -1 : 1;
+	return (pa < pb) ? -1 : 1;
+}
+
+static void writereport() {
+	/* write the profile of prof to reportname */
+	struct hawk_machine * hm = prof;
+	struct profent ** hot;
+	uint64_t total = 0;
+	WORD n = hm->memsize >> 1;
+	WORD i;
+	int nhot = 0;
+	FILE * f;
+
+	/* charge the last instruction fetched */
+	hm->proflast->used += (WORD)(hm->cycles + hm->morecycles
+				       - hm->profcycles);
+	hm->profcycles = hm->cycles + hm->morecycles;
+
+	f = fopen( reportname, "w" );
+	if (f == NULL) {
+		fputs( progname, stderr );
+		fputs( " -p ", stderr );
+		fputs( reportname, stderr );
+		fputs( ": cannot write profile\n", stderr );
+		return;
+	}
+	hot = malloc( sizeof( struct profent * ) * n );
+	if (hot == NULL) {
+		fclose( f );
+		return;
+	}
+	for (i = 0; i < n; i++) {
+		if (hm->prof[i].count != 0) {
+			hot[nhot++] = &hm->prof[i];
+			total += hm->prof[i].used;
+		}
+	}
+	qsort( hot, nhot, sizeof( struct profent * ), byhotness );
+
+	fprintf( f, "%"PRIu64" memory cycles in %d locations\n", total, nhot );
+	fputs( "      cycles      %         count  address  label"
+	       "                     instruction\n", f );
+	for (i = 0; i < (WORD)nhot; i++) {
+		WORD a = (WORD)(hot[i] - hm->prof) << 1;
+		char label[NAME_LENGTH];
+		char op[OPCHARS];
+
+		where( a, label, sizeof( label ), "" );
+		textop( hm, a, op );
+		fprintf( f, "%12"PRIu64" %6.2f %13"PRIu64"  %06"PRIX32
+			 "  %-24s  %s\n", hot[i]->used,
+			 (total == 0) ? 0.0 : (100.0 * hot[i]->used) / total,
+			 hot[i]->count, a, label, op );
+	}
+	if (hm->calls != NULL) writeroutines( f );
+	free( hot );
+	fclose( f );
+}
+
+static void finish() {
+	/* called at exit, write whatever was asked for */
+	if (prof->calls != NULL) {
+		charge( prof );
+		if (foldedname != NULL) writefolded();
+		if (trace != NULL) endtrace( prof->calls );
+	}
+	if (prof->prof != NULL) writereport();
+}
+
+/*************
+ * Interface *
+ *************/
+
+void profile_start( struct hawk_machine * hm, const char * report,
+		    const char * folded, const char * timeline,
+		    const char * listing ) {
+	/* give hm a profile and a call stack and arrange for them to be
+	   reported */
+	if (listing != NULL) readlisting( listing );
+	if (timeline != NULL) {
+		trace = fopen( timeline, "w" );
+		if (trace == NULL) fail( timeline, ": cannot open trace\n" );
+		tracename = timeline;
+	}
+	if (report != NULL) {
+		size_t size = sizeof( struct profent ) * (hm->memsize >> 1);
+		void * p = mmap( NULL, size, PROT_READ | PROT_WRITE,
+				 MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE,
+				 -1, 0 );
+		if (p == MAP_FAILED) {
+			fail( "-p", ": cannot allocate the profile\n" );
+		}
+		hm->prof = p;
+		hm->proflast = &before;
+		hm->profcycles = hm->cycles + hm->morecycles;
+	}
+	if ((folded != NULL) || (timeline != NULL)) {
+		struct callstack * cs = calloc( 1, sizeof( struct callstack ) );
+		if (cs == NULL) fail( "-g", ": out of memory\n" );
+		cs->root.entry = hm->pc;
+		cs->root.calls = 1;
+		cs->top = &cs->root;
+		cs->last = hm->cycles + hm->morecycles;
+		hm->calls = cs;
+		if (trace != NULL) starttrace( cs );
+	}
+	prof = hm;
+	reportname = report;
+	foldedname = folded;
+	atexit( finish );
+}
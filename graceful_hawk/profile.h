@@ -0,0 +1,96 @@
+/* File: profile.h
+   Date: Oct. 16, 2026
+   Language: C (UNIX)
+   Purpose: Hawk Emulator, interface to the execution profiler
+*/
+
+/* assumes prior inclusion of <stdint.h>, "bus.h" and "machine.h" */
+
+/*****************
+ * the profile   *
+ *****************/
+
+/* built with PROFILE, see the Makefile, -p report counts how many times
+   the instruction at each address of core 0 is run and how many memory
+   cycles it uses, from its own fetch to the fetch of the next, so that
+   the cycles of loads, stores and traps are charged to the instruction
+   that made them.  With the MMU on, addresses are virtual.  The block
+   engine and the JIT charge whole blocks at once, so with -p the switch
+   engine runs in their place.
+
+   when the emulator exits, the report is written to the file report,
+   one line per address that was run, hottest first:
+
+	cycles  %  count  address  label  instruction
+
+   where instruction is shown as the console shows it, see showop.h,
+   and label is the nearest label at or below address, with an offset,
+   from the SMAL listing named by -L, if any.  Labels are taken at the
+   addresses the listing shows, so the listing should be of code
+   assembled where it is loaded.
+*/
+struct profent {
+	uint64_t count;  /* times the instruction here was fetched */
+	uint64_t used;   /* memory cycles they used */
+};
+
+/******************
+ * the call graph *
+ ******************/
+
+/* -g folded keeps a shadow call stack for core 0, as -p does, see
+   above.  A JSR or JSRS that links, into a register other than R0,
+   calls the routine it goes to, returning to the address it left in
+   that register.  Any other jump through a register or memory, as by
+   JUMPS R1 or LOADS PC,R2, returns from the innermost routine whose
+   return address it goes to, and from those it called; a jump that
+   goes to no return address on the stack is just a jump.  Traps and
+   interrupts are charged to the routine they interrupt.
+
+   every memory cycle is charged to the chain of calls active when it
+   was used, and when the emulator exits, each chain is written to the
+   file folded as one line, outermost routine first, as flame graph
+   tools read it:
+
+	routine;routine;...;routine  cycles
+
+   where each routine is named by its label from -L, or its address.
+   With -p as well, the report ends with the calls to each routine and
+   the cycles used in it, exclusive, and in it and the routines it
+   called, inclusive, once however deeply it recursed.  A program
+   that loops by calling, never returning, nests deeper each time
+   around, up to MAXDEPTH.
+*/
+#define MAXDEPTH 256 /* deeper calls are charged to their caller */
+
+/*****************
+ * the timeline  *
+ *****************/
+
+/* -T timeline follows calls and returns on the same call stack, and
+   writes an event to the file timeline as each routine is entered and
+   left, in the trace event format that chrome://tracing and Perfetto
+   read.  Events are timed in memory cycles, shown as microseconds,
+   from when the program started or was restored, so the time taken by
+   each routine called in each frame of a program can be seen; at exit,
+   whatever is still running ends.  Events are buffered, and cost about
+   as much as the call or return itself.
+*/
+
+void profile_call( struct hawk_machine * hm, WORD link );
+/* called after a call to pc, returning to link */
+
+void profile_jump( struct hawk_machine * hm );
+/* called after a jump to pc that may be a return */
+
+/*****************
+ * starting      *
+ *****************/
+
+void profile_start( struct hawk_machine * hm, const char * report,
+		    const char * folded, const char * timeline,
+		    const char * listing );
+/* called from main once powerup is done; give hm a profile, one entry
+   per halfword of memory, unless report is NULL, and a call stack,
+   unless folded and timeline are NULL, write them to report, folded
+   and timeline, and read labels from listing, unless it is NULL */
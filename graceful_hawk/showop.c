@@ -4,14 +4,22 @@
    Revised: July 25, 2002 - matches revisions to cpu.c
    Revised: Dec  31, 2007 - matches revisions to cpu.c, improve display style
    Revised: Aug  22, 2008 - use stdint.h, (WORD)casting
+   Revised: Oct  16, 2026 - show memory of the machine hawk, see machine.h
+   Revised: Oct  16, 2026 - add textop, for the profiler
+   Revised: Oct  16, 2026 - show memory of any machine, for the render thread
 
    Language: C (UNIX) with -lcurses option
    Purpose: Hawk Emulator, disassembler for HAWK opcodes
 */
 
 #include <inttypes.h>
+#include <stdio.h>
 #include <curses.h>
 #include "bus.h"
+#include "decode.h"
+#include "block.h"
+#include "mmu.h"
+#include "machine.h"
 #include "showop.h"
 
 /**************************** 
@@ -43,18 +51,18 @@ static char * name;     /* the textual name of the instruction */
 static int form;        /* the instruction format */
 static HALF ir;         /* the memory location */
 
-static void decode( WORD a ) {
+static void decode( struct hawk_machine * hm, WORD a ) {
 	/* decode the opcode in m[a] and stage results in static variables */
 	name = NULL;     /* instruction has no name by default */
 	form = ILLEGAL;  /* instruction is illegal format by default */
 
-	if (a >= MAXMEM) return; /* above maxmem, all are illegal */
+	if (a >= hm->memsize) return; /* above maxmem, all are illegal */
 
 	/* fetch the instruction */
 	if (a & 2) {
-		ir = m[a>>2] >> 16;
+		ir = hm->m[a>>2] >> 16;
 	} else {
-		ir = m[a>>2];
+		ir = hm->m[a>>2];
 	}
 
 	/* decode the instruciton, for its name and format */
@@ -156,75 +164,76 @@ static void decode( WORD a ) {
 	}
 }
 
-static void showit(WORD a) {
+static void showit(struct hawk_machine * hm, WORD a, char * s) {
+	/* put the decoded instruction in s, OPCHARS long */
 	HALF next = 0; /* next word of instruction, if needed */
 
 	/* fetch the next locaton, if needed */
-	if ( ((a + 2) < MAXMEM)
+	if ( ((a + 2) < hm->memsize)
         &&   ((form == LONGMEM) || (form == LONGIMM)) ) {
 		if (a & 2) { /* ir was in the odd half */
-			next = m[(a + 2) >> 2] & (WORD)0xFFFFUL;
+			next = hm->m[(a + 2) >> 2] & (WORD)0xFFFFUL;
 		} else { /* ir was in the even half */
-			next = (m[a >> 2] >> 16) & (WORD)0xFFFFUL;
+			next = (hm->m[a >> 2] >> 16) & (WORD)0xFFFFUL;
 		}
 	}
 
 	/* display it, depending on the format */
 	if (form != ILLEGAL) {
-		addstr(name);
+		s += sprintf(s, "%s", name);
 		switch (form) {
 
 		case LONGMEM:
 			if (X != 0) { /* indexed */
-				printw("R%1X,R%1X,#%04X",
+				sprintf(s, "R%1X,R%1X,#%04X",
 					DST, X, next);
 			} else { /* pc relative */
 				WORD dst = next;
 				if (next & 0x8000) dst |= (WORD)0xFFFF0000UL;
 				dst += a + 4; 
-				printw("R%1X,#%06"PRIX32, DST, dst);
+				sprintf(s, "R%1X,#%06"PRIX32, DST, dst);
 			}
 			break;
 		case SHORTMEM:
-			printw("R%1X,R%1X", DST, X);
+			sprintf(s, "R%1X,R%1X", DST, X);
 			break;
 		case LONGIMM:
-			printw("R%1X,#%06X", DST, (next << 8) | CONST);
+			sprintf(s, "R%1X,#%06X", DST, (next << 8) | CONST);
 			break;
 		case SHORTIMM:
-			printw("R%1X,#%02X", DST, CONST);
+			sprintf(s, "R%1X,#%02X", DST, CONST);
 			break;
 		case BRANCH:
 			{
 				WORD dst = CONST;
 				if (CONST & 128) dst |= (WORD)0xFFFFFF00UL;
 				dst = (dst << 1) + (a + 2);
-				printw("#%06"PRIX32, dst);
+				sprintf(s, "#%06"PRIX32, dst);
 			}
 			break;
 		case SHIFT:
-			printw("R%1X,R%1X,#%1X", DST, S1, S2);
+			sprintf(s, "R%1X,R%1X,#%1X", DST, S1, S2);
 			break;
 		case THREEREG:
-			printw("R%1X,R%1X,R%1X", DST, S1, S2);
+			sprintf(s, "R%1X,R%1X,R%1X", DST, S1, S2);
 			break;
 		case SHORTCON:
-			printw("R%1X,#%1X", DST, SRC);
+			sprintf(s, "R%1X,#%1X", DST, SRC);
 			break;
 		case TWOREG:
-			printw("R%1X,R%1X", DST, SRC);
+			sprintf(s, "R%1X,R%1X", DST, SRC);
 			break;
 		case SPECIAL:
-			printw("R%1X,#%1X", DST, SRC);
+			sprintf(s, "R%1X,#%1X", DST, SRC);
 			break;
 		case NOREG:
 			break;
 		case ONLYCONSTANT:
-			printw("%1X", SRC);
+			sprintf(s, "%1X", SRC);
 			break; 
 		}
 	} else { /* illegal */
-		printw("#%04"PRIX32, ir & (WORD)0x0000FFFFUL);
+		sprintf(s, "#%04"PRIX32, ir & (WORD)0x0000FFFFUL);
 	}
 }
 
@@ -241,15 +250,24 @@ static int mysize() {
  * disassemble one instruction * 
  *******************************/
 
-int showop( WORD a ) {
+int showop( struct hawk_machine * hm, WORD a ) {
 	/* decode the opcode in m[a] and output it; returns address increment */
-	decode( a );
-	showit( a );
+	char s[OPCHARS];
+	decode( hm, a );
+	showit( hm, a, s );
+	addstr( s );
 	return mysize();
 }
 
-int sizeofop( WORD a ) {
+int textop( struct hawk_machine * hm, WORD a, char * s ) {
+	/* decode the opcode in m[a] into s; returns address increment */
+	decode( hm, a );
+	showit( hm, a, s );
+	return mysize();
+}
+
+int sizeofop( struct hawk_machine * hm, WORD a ) {
 	/* decode the opcode in m[a] and return address increment */
-	decode( a );
+	decode( hm, a );
 	return mysize();
 }
@@ -6,14 +6,22 @@
    Purpose: Hawk Emulator, interface to disassembler for HAWK opcodes
 */
 
-/* assumes prior inclusion of <stdint.h> and "bus.h" */
+/* assumes prior inclusion of <stdint.h>, "bus.h" and "machine.h" */
 
 /*******************************
  * disassemble one instruction * 
  *******************************/
 
-int showop( WORD a );
+/* each is given hm, the machine whose memory m holds the opcode, see
+   machine.h */
+
+int showop( struct hawk_machine * hm, WORD a );
 /* decode the opcode in m[a] and output it; returns address increment */
 
-int sizeofop( WORD a );
+int sizeofop( struct hawk_machine * hm, WORD a );
 /* decode the opcode in m[a] and return address increment */
+
+#define OPCHARS 32
+int textop( struct hawk_machine * hm, WORD a, char * s );
+/* decode the opcode in m[a] into the string s, at least OPCHARS long,
+   as showop would output it; returns address increment */
@@ -0,0 +1,136 @@
+/* File: smp.c
+   Date: Oct. 16, 2026
+   Language: C (UNIX, gcc or clang, with -lpthread)
+   Purpose: Hawk Emulator, multiprocessor support;
+		starts one host thread for each core after the first,
+		and keeps the cores' LOADL reservations.
+*/
+
+#ifdef SMP
+
+#include <inttypes.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include <sched.h>
+#include <signal.h>
+#include <unistd.h>
+#include "bus.h"
+#include "console.h"
+#include "decode.h"
+#include "block.h"
+#include "mmu.h"
+#include "smp.h"
+#include "machine.h"
+
+/*****************
+ * the cores     *
+ *****************/
+
+/* what each core runs, from smp_start */
+static void (* corerun)( struct hawk_machine * hm );
+
+static pthread_mutex_t devices = PTHREAD_MUTEX_INITIALIZER;
+
+static void fail() {
+	fputs( progname, stderr );
+	fputs( ": cannot start another core\n", stderr );
+	exit( EXIT_FAILURE ); /* error */
+}
+
+static void * core( void * arg ) {
+	/* the thread for one core other than 0 */
+	struct hawk_machine * hm = arg;
+	__atomic_store_n( &irqs[hm->cpuid], &hm->irq, __ATOMIC_RELEASE );
+	while (!console_running()) usleep( 10000 );
+	corerun( hm );
+	return NULL;
+}
+
+void smp_start( struct hawk_machine * hm0,
+		void (* run)( struct hawk_machine * hm ) ) {
+	/* start cores 1 to ncores-1, sharing the memory of core 0, hm0 */
+	sigset_t all, old;
+	pthread_t t;
+	int i;
+
+	irqs[0] = &hm0->irq;
+	corerun = run;
+
+	/* signals such as control C are for the console, on core 0 */
+	sigfillset( &all );
+	pthread_sigmask( SIG_BLOCK, &all, &old );
+	for (i = 1; i < ncores; i++) {
+		/* a machine of its own, sharing the memory of core 0 */
+		struct hawk_machine * hm = calloc( 1, sizeof( *hm ) );
+		if (hm == NULL) fail();
+		hm->m = hm0->m;
+		hm->memsize = hm0->memsize;
+		hm->romsize = hm0->romsize;
+		hm->dcache = hm0->dcache;
+		hm->dpage = hm0->dpage;
+		hm->cpuid = i;
+		mmu_flush( hm );
+
+		links[i] = NOLINK;
+		if (pthread_create( &t, NULL, core, hm )) fail();
+		pthread_detach( t );
+	}
+	pthread_sigmask( SIG_SETMASK, &old, NULL );
+
+	/* no core may interrupt another before it has an irq */
+	for (i = 1; i < ncores; i++) {
+		while (__atomic_load_n( &irqs[i], __ATOMIC_ACQUIRE ) == NULL) {
+			sched_yield();
+		}
+	}
+}
+
+void smp_console( struct hawk_machine * hm ) {
+	/* called on cores other than 0 instead of console() */
+	if ((hm->pc == 0) && (hm->instructions != 0)) { /* core is done */
+		for (;;) pause();
+	}
+	while (!console_running()) usleep( 10000 );
+	if (!(hm->cycles & 0x80000000UL)) {
+		hm->cycles -= recycle;
+		hm->morecycles += recycle;
+	}
+}
+
+void smp_lock() {
+	pthread_mutex_lock( &devices );
+}
+
+void smp_unlock() {
+	pthread_mutex_unlock( &devices );
+}
+
+/**********************
+ * LOADL and STOREC   *
+ **********************/
+
+WORD links[ MAXCORES ] = { NOLINK };
+
+void smp_link( struct hawk_machine * hm, WORD a, WORD val ) {
+	/* LOADL of val from physical address a */
+	__atomic_store_n( &links[hm->cpuid], a, __ATOMIC_SEQ_CST );
+	hm->linked = val;
+}
+
+int smp_storec( struct hawk_machine * hm, WORD a, WORD val ) {
+	/* STOREC of val into RAM at a, if this core still holds a */
+	WORD expect = a;
+	if (!__atomic_compare_exchange_n( &links[hm->cpuid], &expect, NOLINK,
+					  0, __ATOMIC_SEQ_CST,
+					  __ATOMIC_SEQ_CST )) return 0;
+	expect = hm->linked;
+	if (!__atomic_compare_exchange_n( &hm->m[a >> 2], &expect, val, 0,
+					  __ATOMIC_SEQ_CST,
+					  __ATOMIC_SEQ_CST )) return 0;
+	SMP_STORED( a );
+	return 1;
+}
+
+#endif
@@ -0,0 +1,85 @@
+/* File: smp.h
+   Date: Oct. 16, 2026
+   Language: C (UNIX)
+   Purpose: Hawk Emulator, interface to multiprocessor support
+*/
+
+/* assumes prior inclusion of <stdint.h> and "bus.h" */
+
+/*****************
+ * the cores     *
+ *****************/
+
+/* built with SMP, see Makefile, -P n gives n Hawk CPUs, or cores,
+   sharing memory, each run by its own host thread with its own
+   registers, psw, trap registers, irq, coprocessor, TLB and LOADL
+   reservation, each a machine of its own, see machine.h.  Core 0 is
+   the machine on the console, and runs on the main thread; it is the
+   one the console shows and controls, and the only one the keyboard
+   interrupts.  The others run while the console is running and wait
+   while it is stopped.  All start at location zero with psw zero, and
+   tell themselves apart with CPUGET:
+
+	CPUGET  x,CORE  gets the number of this core, 0 to ncores-1, in
+	                the low byte of x and ncores in the next byte
+	CPUSET  x,CORE  raises the interrupt requests in bits 1 to 7 of x
+	                on the core numbered by the next byte of x, or,
+	                if bit 0 of x is set, retracts them
+
+   a core other than 0 that reaches location zero stops for good.  With
+   more than one core, the block and jit engines give way to the switch
+   engine, and there are no snapshots.
+*/
+#define CORE 0x6        /* CPUSET and CPUGET register number */
+
+void smp_start( struct hawk_machine * hm0,
+		void (* run)( struct hawk_machine * hm ) );
+/* call from main on core 0, hm0, before it runs; starts the other
+   cores, each calling run with its own machine on its own thread */
+
+void smp_console( struct hawk_machine * hm );
+/* call on cores other than 0 whenever core 0 would call console() */
+
+void smp_lock();
+void smp_unlock();
+/* hold while touching devices or calling console(), which are not
+   written for more than one thread */
+
+/**********************
+ * LOADL and STOREC   *
+ **********************/
+
+/* a LOADL on one core and the STOREC after it must notice stores into
+   that word by other cores in between.  links holds the reservation of
+   each core, the physical address of its last LOADL, and every store
+   into memory clears the reservations on the word it stores into.
+   Every core reads and writes links, so it is only touched with
+   atomic operations.  STOREC first drops its core's reservation with a
+   compare and swap, failing if it was already gone, so a store by
+   another core that cleared it, even one that put back the value LOADL
+   loaded, makes it fail; then it stores with a compare and swap
+   against that value, so a store that slips in after the reservation
+   is dropped makes it fail instead of being lost */
+#define NOLINK 1        /* a reservation that matches no word */
+
+extern WORD links[ MAXCORES ];
+
+#define SMP_STORED(a) {							\
+	int i_;								\
+	for (i_ = 0; i_ < ncores; i_++) {				\
+		WORD l_ = (a);						\
+		if (__atomic_load_n( &links[i_], __ATOMIC_ACQUIRE ) == l_) { \
+			__atomic_compare_exchange_n( &links[i_], &l_,	\
+						     NOLINK, 0,		\
+						     __ATOMIC_SEQ_CST,	\
+						     __ATOMIC_SEQ_CST ); \
+		}							\
+	}								\
+}
+
+void smp_link( struct hawk_machine * hm, WORD a, WORD val );
+/* LOADL of val from physical address a by core hm */
+
+int smp_storec( struct hawk_machine * hm, WORD a, WORD val );
+/* STOREC of val into physical address a, a in RAM; returns zero if the
+   reservation was lost, and nonzero once val is stored */
@@ -0,0 +1,175 @@
+/* File: snapshot.c
+   Date: Oct. 16, 2026
+   Language: C (UNIX)
+   Purpose: Hawk Emulator, machine state snapshots;
+		saves the state of the machine between instructions and
+		restores it at powerup by mapping the saved memory image.
+*/
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "bus.h"
+#include "float.h"
+#include "console.h"
+#include "powerup.h"
+#include "decode.h"
+#include "block.h"
+#include "mmu.h"
+#include "machine.h"
+#include "snapshot.h"
+
+/***********************
+ * snapshot file format *
+ ***********************/
+
+#define MAGIC   "HAWKSNAP"
+#define VERSION ((WORD)0x00010003UL) /* reads backward on a foreign host */
+
+/* memory starts at this offset in the file; a multiple of the page size
+   of any likely host, and big enough for the header */
+#define MEMOFFSET 0x10000
+
+struct header {
+	char magic[8];
+	WORD version;
+	WORD memsize;
+	WORD romsize;
+	WORD r[16];
+	WORD pc;
+	WORD psw;
+	WORD tpc;
+	WORD tma;
+	WORD tsv;
+	WORD irq;
+	WORD costat;
+	WORD cocc;
+	WORD kbd;        /* see kbd_state */
+	WORD fplow;
+	double fpa[2];
+	struct tlbent tlb[ TLBSIZE ];
+	WORD tlbnext;
+	WORD cycles;     /* cycles + morecycles */
+	uint64_t instructions;
+	WORD counters[16]; /* see bus.h */
+};
+
+/*************
+ * Interface *
+ *************/
+
+int snapshot_save( struct hawk_machine * hm, const char * name ) {
+	/* save the state of hm in the file name; returns zero on failure */
+	struct header h;
+	FILE * f;
+	int ok;
+
+	if (ncores > 1) return 0; /* it would hold only one core, see smp.h */
+	memset( &h, 0, sizeof( h ) );
+	memcpy( h.magic, MAGIC, 8 );
+	h.version = VERSION;
+	h.memsize = hm->memsize;
+	h.romsize = hm->romsize;
+	memcpy( h.r, hm->r, sizeof( h.r ) );
+	h.r[0] = 0;
+	h.pc = hm->pc;
+	h.psw = hm->psw;
+	h.tpc = hm->tpc;
+	h.tma = hm->tma;
+	h.tsv = hm->tsv;
+	h.irq = hm->irq;
+	h.costat = hm->costat;
+	h.cocc = hm->cocc;
+	h.kbd = kbd_state();
+	h.fplow = hm->fplow;
+	h.fpa[0] = hm->fpa[0];
+	h.fpa[1] = hm->fpa[1];
+	memcpy( h.tlb, hm->tlb, sizeof( h.tlb ) );
+	h.tlbnext = hm->tlbnext;
+	h.cycles = hm->cycles + hm->morecycles;
+	h.instructions = hm->instructions;
+	memcpy( h.counters, hm->counters, sizeof( h.counters ) );
+
+	f = fopen( name, "w" );
+	if (f == NULL) return 0;
+	ok = (fwrite( &h, sizeof( h ), 1, f ) == 1)
+	  && (fseek( f, MEMOFFSET, SEEK_SET ) == 0)
+	  && (fwrite( hm->m, hm->memsize, 1, f ) == 1);
+	if (fclose( f ) != 0) ok = 0;
+	return ok;
+}
+
+static void bad( const char * name, const char * why ) {
+	/* complain about the snapshot file name and exit */
+	fputs( progname, stderr );
+	fputs( " -R ", stderr );
+	fputs( name, stderr );
+	fputs( ": ", stderr );
+	fputs( why, stderr );
+	fputs( "\n", stderr );
+	exit( EXIT_FAILURE ); /* error */
+}
+
+void snapshot_restore( struct hawk_machine * hm, const char * name ) {
+	/* restore the state of hm from the file name */
+	struct header h;
+	struct stat st;
+	int fd;
+
+	fd = open( name, O_RDONLY );
+	if (fd < 0) bad( name, "cannot open snapshot" );
+	if ((read( fd, &h, sizeof( h ) ) != sizeof( h ))
+	||  (memcmp( h.magic, MAGIC, 8 ) != 0)) {
+		bad( name, "not a snapshot" );
+	}
+	if (h.version != VERSION) {
+		bad( name, "snapshot from another version or host" );
+	}
+	if (hm->m == NULL) { /* memory is sized to fit */
+		hm->memsize = h.memsize;
+		hm->romsize = h.romsize;
+		powerup_memory( hm );
+	} else if ((h.memsize != hm->memsize)
+	       ||  (h.romsize != hm->romsize)) {
+		bad( name, "snapshot of a different memory size" );
+	}
+	if ((fstat( fd, &st ) != 0)
+	||  (st.st_size < (off_t)MEMOFFSET + (off_t)hm->memsize)) {
+		bad( name, "snapshot is truncated" );
+	}
+
+	/* memory is a private copy-on-write mapping of the file, so pages
+	   are read in only when the program touches them */
+	if (mmap( hm->m, hm->memsize, PROT_READ | PROT_WRITE,
+		  MAP_PRIVATE | MAP_FIXED, fd, MEMOFFSET ) == MAP_FAILED) {
+		bad( name, "cannot map snapshot" );
+	}
+	close( fd );
+
+	memcpy( hm->r, h.r, sizeof( h.r ) );
+	hm->pc = h.pc;
+	hm->psw = h.psw;
+	hm->tpc = h.tpc;
+	hm->tma = h.tma;
+	hm->tsv = h.tsv;
+	hm->irq = h.irq;
+	hm->costat = h.costat;
+	hm->cocc = h.cocc;
+	kbd_setstate( h.kbd );
+	hm->fplow = h.fplow;
+	hm->fpa[0] = h.fpa[0];
+	hm->fpa[1] = h.fpa[1];
+	memcpy( hm->tlb, h.tlb, sizeof( h.tlb ) );
+	hm->tlbnext = h.tlbnext & TLBMASK;
+	mmu_flush( hm );
+	hm->morecycles = h.cycles;
+	hm->cycles = 0;
+	hm->instructions = h.instructions;
+	memcpy( hm->counters, h.counters, sizeof( h.counters ) );
+	restored = 1;
+}
@@ -0,0 +1,34 @@
+/* File: snapshot.h
+   Date: Oct. 16, 2026
+   Language: C (UNIX)
+   Purpose: Hawk Emulator, interface to machine state snapshots
+*/
+
+/* assumes prior inclusion of <stdint.h> and "bus.h" */
+
+/*********************
+ * snapshot files    *
+ *********************/
+
+/* a snapshot of a machine, see machine.h, holds memory, the
+   registers, the trap registers, the TLB, the coprocessor state, the
+   keyboard state and the cycle and instruction counts, all in host byte
+   order.  Memory starts on a page boundary so that restoring maps it
+   straight from the file.  The display, the breakpoint and the console
+   settings are not part of the program's state, so they are not saved.
+
+   snapshots are only taken between instructions, with psw packed, as
+   it is whenever console() is called; restoring one at powerup sets
+   restored so that main picks up where the snapshot left off instead
+   of starting from location zero.
+*/
+#define SNAPNAME "hawk.snap" /* the default snapshot file */
+
+int snapshot_save( struct hawk_machine * hm, const char * name );
+/* save the state of hm in the file name; returns zero on failure,
+   as it does with more than one core */
+
+void snapshot_restore( struct hawk_machine * hm, const char * name );
+/* restore the state of hm from the file name, or exit with an error
+   message if it is not a snapshot; memory takes the size it had in the
+   snapshot, unless it was already set up with a different size */